@@ -0,0 +1,61 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+
+/*****************************************************************************
+*   example fiber function
+*****************************************************************************/
+std::thread::id whatevah( char me) {
+    std::thread::id my_thread = std::this_thread::get_id(); /*< get ID of initial thread >*/
+    for ( unsigned i = 0; i < 10; ++i) { /*< loop ten times >*/
+        boost::this_fiber::yield(); /*< yield to other fibers >*/
+        std::thread::id new_thread = std::this_thread::get_id();
+        if ( new_thread != my_thread) { /*< test if fiber was migrated to another thread >*/
+            my_thread = new_thread;
+            std::ostringstream buffer;
+            buffer << "fiber " << me << " switched to thread " << my_thread << '\n';
+            std::cout << buffer.str() << std::flush;
+        }
+    }
+    return my_thread;
+}
+
+/*****************************************************************************
+*   main()
+*****************************************************************************/
+int main() {
+    std::cout << "main thread started " << std::this_thread::get_id() << std::endl;
+//[main_pool
+    boost::fibers::pool p{ 4,
+        boost::fibers::pool::algorithm< boost::fibers::algo::work_stealing >( 4) }; /*<
+        Launch four threads, each thread installs the scheduling algorithm
+        `boost::fibers::algo::work_stealing`. The constructor returns if all
+        threads are ready.
+    >*/
+    std::vector< boost::fibers::future< std::thread::id > > results;
+    for ( char c : std::string("abcdefghijklmnopqrstuvwxyz")) { /*<
+        Submit a number of tasks from the main thread; each task runs in its
+        own fiber in one of the threads of the pool.
+    >*/
+        results.push_back( p.submit( whatevah, c) );
+    }
+    for ( boost::fibers::future< std::thread::id > & f : results) {
+        f.get();
+    }
+    p.shutdown(); /*<
+        Wait till all submitted tasks are complete and join the threads.
+    >*/
+//]
+    std::cout << "done." << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -8,21 +8,21 @@
 #ifndef BOOST_FIBERS_ALGO_NUMA_WORK_STEALING_H
 #define BOOST_FIBERS_ALGO_NUMA_WORK_STEALING_H
 
-#include <condition_variable>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <mutex>
+#include <memory>
 #include <vector>
 
 #include <boost/config.hpp>
 #include <boost/intrusive_ptr.hpp>
 
 #include <boost/fiber/algo/algorithm.hpp>
+#include <boost/fiber/algo/stealing_domain.hpp>
 #include <boost/fiber/context.hpp>
 #include <boost/fiber/detail/config.hpp>
-#include <boost/fiber/detail/context_spinlock_queue.hpp>
-#include <boost/fiber/detail/context_spmc_queue.hpp>
+#include <boost/fiber/detail/parker.hpp>
+#include <boost/fiber/numa/memory.hpp>
 #include <boost/fiber/numa/pin_thread.hpp>
 #include <boost/fiber/numa/topology.hpp>
 #include <boost/fiber/scheduler.hpp>
@@ -36,29 +36,65 @@ namespace fibers {
 namespace algo {
 namespace numa {
 
+// migration of the stack memory of fibers running on a remote NUMA node
+struct memory_migration {
+    // stacks are not migrated by default
+    bool                enabled{ false };
+    // a fiber is migrated if it has been resumed `threshold` times in a
+    // row on another NUMA node than its stack memory (`1`: migrated by
+    // the first resumption after a steal)
+    std::uint32_t       threshold{ 1 };
+    // bytes at the top of the stack (context and the frames used most
+    // recently) that are migrated
+    std::size_t         stack_bytes{ 16 * 1024 };
+};
+
 class work_stealing : public algorithm {
 private:
-    static std::vector< intrusive_ptr< work_stealing > >    schedulers_;
-
+    // slots are indexed by the ID of the logical cpu
+    std::shared_ptr< stealing_domain >                      domain_;
     std::uint32_t                                           cpu_id_;
-    std::vector< std::uint32_t >                            local_cpus_;
-    std::vector< std::uint32_t >                            remote_cpus_;
-#ifdef BOOST_FIBERS_USE_SPMC_QUEUE
-    detail::context_spmc_queue                              rqueue_{};
-#else
-    detail::context_spinlock_queue                          rqueue_{};
-#endif
-    std::mutex                                              mtx_{};
-    std::condition_variable                                 cnd_{};
-    bool                                                    flag_{ false };
+    std::uint32_t                                           node_id_;
+    // logical cpus of the local NUMA node, grouped by the
+    // core and caches shared with cpu_id_
+    std::vector< std::vector< std::uint32_t > >             local_tiers_;
+    // logical cpus of the remote NUMA nodes, grouped by distance
+    std::vector< std::vector< std::uint32_t > >             remote_tiers_;
+    // owned by the domain
+    stealing_domain::ready_queue_type                   &   rqueue_;
+    // main- and dispatcher-context, never stolen
+    scheduler::ready_queue_type                             pinned_{};
+    // picks left before a pending pinned context goes first
+    std::uint32_t                                           pinned_wait_{ 0 };
+    detail::parker                                          parker_{};
+    memory_migration                                        migration_{};
     bool                                                    suspend_;
 
-    static void init_( std::vector< boost::fibers::numa::node > const&,
-                       std::vector< intrusive_ptr< work_stealing > > &);
+    void track_node_( context *) noexcept;
 
 public:
+    // size of a domain suitable for topology
+    // (one slot per logical cpu, indexed by the cpu ID)
+    static std::uint32_t domain_size( std::vector< boost::fibers::numa::node > const&) noexcept;
+
+    // joins the process-wide domain
+    work_stealing( std::uint32_t, std::uint32_t,
+                   std::vector< boost::fibers::numa::node > const&,
+                   bool = false);
+
+    // joins domain, fibers are stolen only from schedulers
+    // of the same domain
+    work_stealing( std::uint32_t, std::uint32_t,
+                   std::vector< boost::fibers::numa::node > const&,
+                   std::shared_ptr< stealing_domain >,
+                   bool = false);
+
+    // stacks of fibers resumed on this NUMA node are migrated as
+    // specified by migration
     work_stealing( std::uint32_t, std::uint32_t,
                    std::vector< boost::fibers::numa::node > const&,
+                   std::shared_ptr< stealing_domain >,
+                   memory_migration const&,
                    bool = false);
 
     work_stealing( work_stealing const&) = delete;
@@ -76,7 +112,7 @@ public:
     }
 
     virtual bool has_ready_fibers() const noexcept {
-        return ! rqueue_.empty();
+        return ! rqueue_.empty() || ! pinned_.empty();
     }
 
     virtual void suspend_until( std::chrono::steady_clock::time_point const&) noexcept;
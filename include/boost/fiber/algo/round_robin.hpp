@@ -6,15 +6,14 @@
 #ifndef BOOST_FIBERS_ALGO_ROUND_ROBIN_H
 #define BOOST_FIBERS_ALGO_ROUND_ROBIN_H
 
-#include <condition_variable>
 #include <chrono>
-#include <mutex>
 
 #include <boost/config.hpp>
 
 #include <boost/fiber/algo/algorithm.hpp>
 #include <boost/fiber/context.hpp>
 #include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/parker.hpp>
 #include <boost/fiber/scheduler.hpp>
 
 #ifdef BOOST_HAS_ABI_HEADERS
@@ -35,9 +34,8 @@ private:
     typedef scheduler::ready_queue_type rqueue_type;
 
     rqueue_type                 rqueue_{};
-    std::mutex                  mtx_{};
-    std::condition_variable     cnd_{};
-    bool                        flag_{ false };
+    std::size_t                 rqueue_size_{ 0 };
+    detail::parker              parker_{};
 
 public:
     round_robin() = default;
@@ -0,0 +1,316 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef BOOST_FIBERS_ALGO_STEALING_DOMAIN_H
+#define BOOST_FIBERS_ALGO_STEALING_DOMAIN_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/context_ready_queue.hpp>
+#include <boost/fiber/detail/context_spinlock_queue.hpp>
+#include <boost/fiber/detail/parker.hpp>
+#include <boost/fiber/exceptions.hpp>
+#include <boost/fiber/policy.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace algo {
+
+// set of schedulers stealing fibers from each other
+// each scheduler of a domain owns a slot holding its ready-queue;
+// the ready-queues are owned by the domain, so that a queue can be
+// robbed as long as the domain exists, even if the thread of the
+// owning scheduler has already terminated
+// the domain is shared by the algorithms (std::shared_ptr); schedulers
+// of different domains never steal from each other
+// schedulers might join and retire at runtime: victims are selected
+// from the live slots, ready fibers of a retiring scheduler are
+// migrated via the overflow queue (multi-producer)
+// idle schedulers are woken up following a spinning-thief protocol:
+// new work wakes one parked scheduler only if no thief is spinning,
+// the number of concurrently spinning thieves is capped
+// the kind of the ready-queues is selected by the ready_queue_policy
+// passed to the constructor; a bounded ready-queue spills to the
+// overflow queue
+class stealing_domain {
+public:
+    typedef detail::context_ready_queue     ready_queue_type;
+
+    // policy of domains constructed without an explicit policy
+    static constexpr ready_queue_policy default_policy() noexcept {
+#ifdef BOOST_FIBERS_USE_SPMC_QUEUE
+        return ready_queue_policy::spmc;
+#else
+        return ready_queue_policy::spinlock;
+#endif
+    }
+
+private:
+    struct slot {
+        ready_queue_type        rqueue{};
+        detail::parker          parker{};
+        // set while the owning scheduler is (about to be) parked
+        std::atomic< bool >     parked{ false };
+        // protected by mtx_
+        bool                    used{ false };
+        bool                    parks{ false };
+        // avoid false sharing between queues of different slots
+        char                    pad[cacheline_length];
+    };
+
+    const std::uint32_t                                 size_;
+    const ready_queue_policy                            policy_;
+    std::unique_ptr< slot[] >                           slots_;
+    // dense array of the indices of the live slots, written under mtx_
+    // readers might see a stale entry which is still a valid index
+    std::unique_ptr< std::atomic< std::uint32_t >[] >  live_;
+    std::atomic< std::uint32_t >                        live_count_{ 0 };
+    std::atomic< std::uint32_t >                        idle_count_{ 0 };
+    // slots whose scheduler might park, written under mtx_
+    std::atomic< std::uint32_t >                        parking_count_{ 0 };
+    std::atomic< std::uint32_t >                        spinning_{ 0 };
+    detail::context_spinlock_queue                      overflow_{};
+    std::mutex                                          mtx_{};
+
+    void remove_live_( std::uint32_t idx) noexcept {
+        const std::uint32_t count = live_count_.load( std::memory_order_relaxed);
+        for ( std::uint32_t i = 0; i < count; ++i) {
+            if ( idx == live_[i].load( std::memory_order_relaxed) ) {
+                live_[i].store( live_[count - 1].load( std::memory_order_relaxed), std::memory_order_relaxed);
+                live_count_.store( count - 1, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+public:
+    explicit stealing_domain( std::uint32_t size,
+                              ready_queue_policy policy = default_policy() ) :
+        size_{ size },
+        policy_{ policy },
+        slots_{ new slot[size] },
+        live_{ new std::atomic< std::uint32_t >[size] } {
+        if ( BOOST_UNLIKELY( 0 == size_) ) {
+            throw fiber_error{ std::make_error_code( std::errc::invalid_argument),
+                               "boost fiber: stealing domain requires at least one slot" };
+        }
+        for ( std::uint32_t i = 0; i < size_; ++i) {
+            slots_[i].rqueue.reset( policy_, overflow_);
+            live_[i].store( 0, std::memory_order_relaxed);
+        }
+    }
+
+    stealing_domain( stealing_domain const&) = delete;
+    stealing_domain & operator=( stealing_domain const&) = delete;
+
+    // number of picks a pinned context (main-, dispatcher-context) waits if
+    // queued behind `queued` ready fibers: one round of the local ready-queue,
+    // at most BOOST_FIBERS_PINNED_WAIT_MAX picks
+    static std::uint32_t pinned_wait( std::size_t queued) noexcept {
+        return queued < BOOST_FIBERS_PINNED_WAIT_MAX
+            ? static_cast< std::uint32_t >( queued)
+            : BOOST_FIBERS_PINNED_WAIT_MAX;
+    }
+
+    std::uint32_t size() const noexcept {
+        return size_;
+    }
+
+    ready_queue_policy policy() const noexcept {
+        return policy_;
+    }
+
+    // claim an unused slot, the slot becomes live; parks is set if
+    // the scheduler of the slot suspends its thread if idle
+    std::uint32_t acquire_slot( bool parks = true) {
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        for ( std::uint32_t idx = 0; idx < size_; ++idx) {
+            if ( ! slots_[idx].used) {
+                slots_[idx].used = true;
+                slots_[idx].parks = parks;
+                if ( parks) {
+                    parking_count_.fetch_add( 1, std::memory_order_relaxed);
+                }
+                const std::uint32_t count = live_count_.load( std::memory_order_relaxed);
+                live_[count].store( idx, std::memory_order_relaxed);
+                live_count_.store( count + 1, std::memory_order_release);
+                return idx;
+            }
+        }
+        throw fiber_error{ std::make_error_code( std::errc::resource_unavailable_try_again),
+                           "boost fiber: all slots of the stealing domain are in use" };
+    }
+
+    // the slot is no longer selected as victim nor woken up
+    void retire_slot( std::uint32_t idx) noexcept {
+        BOOST_ASSERT( idx < size_);
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        remove_live_( idx);
+    }
+
+    // the slot might be claimed again
+    void release_slot( std::uint32_t idx) noexcept {
+        BOOST_ASSERT( idx < size_);
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        remove_live_( idx);
+        slots_[idx].used = false;
+        if ( slots_[idx].parks) {
+            parking_count_.fetch_sub( 1, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint32_t live_count() const noexcept {
+        return live_count_.load( std::memory_order_acquire);
+    }
+
+    // n-th live slot, n < live_count()
+    std::uint32_t live_slot( std::uint32_t n) const noexcept {
+        BOOST_ASSERT( n < size_);
+        return live_[n].load( std::memory_order_relaxed);
+    }
+
+    // ready fibers migrated from retiring schedulers or
+    // spilled by bounded ready-queues
+    detail::context_spinlock_queue & overflow() noexcept {
+        return overflow_;
+    }
+
+    // parks the scheduler of slot idx; if recheck is set, the scheduler
+    // is not parked if one of the live queues or the overflow queue
+    // contains ready fibers
+    void park_until( std::uint32_t idx, std::chrono::steady_clock::time_point const& time_point,
+                     bool recheck = true) noexcept {
+        slot & s = slots_[idx];
+        s.parked.store( true, std::memory_order_relaxed);
+        idle_count_.fetch_add( 1, std::memory_order_relaxed);
+        // pairs with the fence in notify_idle()
+        std::atomic_thread_fence( std::memory_order_seq_cst);
+        bool work = false;
+        if ( recheck) {
+            work = ! overflow_.empty();
+            const std::uint32_t count = live_count();
+            for ( std::uint32_t i = 0; ! work && i < count; ++i) {
+                work = ! slots_[live_slot( i)].rqueue.empty();
+            }
+        }
+        if ( ! work) {
+            s.parker.park_until( time_point);
+        }
+        s.parked.store( false, std::memory_order_relaxed);
+        idle_count_.fetch_sub( 1, std::memory_order_relaxed);
+    }
+
+    // parks the retired scheduler of slot idx; a retired scheduler runs
+    // migrated fibers only if no live scheduler is left, thus it is not
+    // parked only if the overflow queue is non-empty and no slot is live
+    // (woken up by notify_idle() if the last live scheduler is gone)
+    void park_retired_until( std::uint32_t idx, std::chrono::steady_clock::time_point const& time_point) noexcept {
+        slot & s = slots_[idx];
+        s.parked.store( true, std::memory_order_relaxed);
+        idle_count_.fetch_add( 1, std::memory_order_relaxed);
+        // pairs with the fence in notify_idle()
+        std::atomic_thread_fence( std::memory_order_seq_cst);
+        if ( 0 != live_count() || overflow_.empty() ) {
+            s.parker.park_until( time_point);
+        }
+        s.parked.store( false, std::memory_order_relaxed);
+        idle_count_.fetch_sub( 1, std::memory_order_relaxed);
+    }
+
+    void unpark( std::uint32_t idx) noexcept {
+        slots_[idx].parker.unpark();
+    }
+
+    // the calling scheduler becomes a spinning thief; returns false if
+    // already half of the busy schedulers are spinning (at least one
+    // thief is admitted), the caller should park without stealing
+    bool begin_spinning() noexcept {
+        const std::uint32_t live = live_count();
+        const std::uint32_t idle = idle_count_.load( std::memory_order_relaxed);
+        const std::uint32_t busy = idle < live ? live - idle : 1;
+        std::uint32_t spinning = spinning_.load( std::memory_order_relaxed);
+        do {
+            if ( 0 != spinning && 2 * spinning >= busy) {
+                return false;
+            }
+        } while ( ! spinning_.compare_exchange_weak(
+                    spinning, spinning + 1, std::memory_order_relaxed) );
+        return true;
+    }
+
+    // the scheduler of slot idx stops spinning; if it found work and was
+    // the last spinning thief, one parked scheduler is woken up
+    // so that the parallelism ramps up
+    void end_spinning( std::uint32_t idx, bool found) noexcept {
+        // seq_cst: a thief giving up re-checks the queues in park_until()
+        if ( 1 == spinning_.fetch_sub( 1, std::memory_order_seq_cst) && found) {
+            notify_idle( idx);
+        }
+    }
+
+    // ready fibers have been queued by the scheduler of slot idx, wake up
+    // one parked scheduler unless a spinning thief will pick them up
+    void notify_idle( std::uint32_t idx) noexcept {
+        if ( 0 == parking_count_.load( std::memory_order_relaxed) ) {
+            // no scheduler of the domain ever parks (a scheduler joining
+            // meanwhile re-checks the queues before it parks)
+            return;
+        }
+        // pairs with the fence in park_until()
+        std::atomic_thread_fence( std::memory_order_seq_cst);
+        if ( 0 != spinning_.load( std::memory_order_relaxed) ||
+             0 == idle_count_.load( std::memory_order_relaxed) ) {
+            return;
+        }
+        const std::uint32_t count = live_count();
+        for ( std::uint32_t i = 0; i < count; ++i) {
+            const std::uint32_t victim = live_slot( i);
+            if ( victim != idx &&
+                 slots_[victim].parked.exchange( false, std::memory_order_relaxed) ) {
+                slots_[victim].parker.unpark();
+                return;
+            }
+        }
+        if ( 0 == count) {
+            // no live scheduler left, a retired scheduler
+            // runs the fibers of the overflow queue
+            for ( std::uint32_t victim = 0; victim < size_; ++victim) {
+                if ( victim != idx &&
+                     slots_[victim].parked.exchange( false, std::memory_order_relaxed) ) {
+                    slots_[victim].parker.unpark();
+                    return;
+                }
+            }
+        }
+    }
+
+    ready_queue_type & queue( std::uint32_t idx) noexcept {
+        BOOST_ASSERT( idx < size_);
+        return slots_[idx].rqueue;
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_ALGO_STEALING_DOMAIN_H
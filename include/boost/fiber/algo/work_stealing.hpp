@@ -9,21 +9,18 @@
 #define BOOST_FIBERS_ALGO_WORK_STEALING_H
 
 #include <atomic>
-#include <condition_variable>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <mutex>
-#include <vector>
+#include <memory>
 
 #include <boost/config.hpp>
 #include <boost/intrusive_ptr.hpp>
 
 #include <boost/fiber/algo/algorithm.hpp>
+#include <boost/fiber/algo/stealing_domain.hpp>
 #include <boost/fiber/context.hpp>
 #include <boost/fiber/detail/config.hpp>
-#include <boost/fiber/detail/context_spinlock_queue.hpp>
-#include <boost/fiber/detail/context_spmc_queue.hpp>
 #include <boost/fiber/scheduler.hpp>
 
 #ifdef BOOST_HAS_ABI_HEADERS
@@ -36,32 +33,48 @@ namespace algo {
 
 class work_stealing : public algorithm {
 private:
-    static std::atomic< std::uint32_t >                     counter_;
-    static std::vector< intrusive_ptr< work_stealing > >    schedulers_;
-
+    std::shared_ptr< stealing_domain >                      domain_;
     std::uint32_t                                           id_;
-    std::uint32_t                                           thread_count_;
-#ifdef BOOST_FIBERS_USE_SPMC_QUEUE
-    detail::context_spmc_queue                              rqueue_{};
-#else
-    detail::context_spinlock_queue                          rqueue_{};
-#endif
-    std::mutex                                              mtx_{};
-    std::condition_variable                                 cnd_{};
-    bool                                                    flag_{ false };
+    // owned by the domain
+    stealing_domain::ready_queue_type                   &   rqueue_;
+    // main- and dispatcher-context, never stolen
+    scheduler::ready_queue_type                             pinned_{};
+    // picks left before a pending pinned context goes first
+    std::uint32_t                                           pinned_wait_{ 0 };
     bool                                                    suspend_;
+    bool                                                    retiring_{ false };
+    // the last steal was refused because enough thieves are spinning
+    bool                                                    throttled_{ false };
 
-    static void init_( std::uint32_t, std::vector< intrusive_ptr< work_stealing > > &);
+    void migrate_( context *) noexcept;
 
 public:
+    // joins the process-wide domain, its size is determined
+    // by the first call
     work_stealing( std::uint32_t, bool = false);
 
+    // joins domain, fibers are stolen only from schedulers
+    // of the same domain
+    work_stealing( std::shared_ptr< stealing_domain >, bool = false);
+
+    // the slot is released, remaining ready fibers are migrated
+    // to the live schedulers of the domain
+    virtual ~work_stealing();
+
     work_stealing( work_stealing const&) = delete;
     work_stealing( work_stealing &&) = delete;
 
     work_stealing & operator=( work_stealing const&) = delete;
     work_stealing & operator=( work_stealing &&) = delete;
 
+    // the scheduler leaves the domain: it is no longer robbed and
+    // its ready fibers are migrated to the live schedulers of the domain
+    void retire() noexcept;
+
+    bool is_retiring() const noexcept {
+        return retiring_;
+    }
+
     virtual void awakened( context *) noexcept;
 
     virtual context * pick_next() noexcept;
@@ -71,7 +84,7 @@ public:
     }
 
     virtual bool has_ready_fibers() const noexcept {
-        return ! rqueue_.empty();
+        return ! rqueue_.empty() || ! pinned_.empty();
     }
 
     virtual void suspend_until( std::chrono::steady_clock::time_point const&) noexcept;
@@ -12,8 +12,10 @@
 #include <boost/fiber/algo/shared_work.hpp>
 #include <boost/fiber/algo/work_stealing.hpp>
 #include <boost/fiber/algo/numa/work_stealing.hpp>
+#include <boost/fiber/arena_fixedsize_stack.hpp>
 #include <boost/fiber/barrier.hpp>
 #include <boost/fiber/buffered_channel.hpp>
+#include <boost/fiber/caching_fixedsize_stack.hpp>
 #include <boost/fiber/channel_op_status.hpp>
 #include <boost/fiber/condition_variable.hpp>
 #include <boost/fiber/context.hpp>
@@ -22,11 +24,14 @@
 #include <boost/fiber/fixedsize_stack.hpp>
 #include <boost/fiber/fss.hpp>
 #include <boost/fiber/future.hpp>
+#include <boost/fiber/numa/memory.hpp>
 #include <boost/fiber/numa/pin_thread.hpp>
+#include <boost/fiber/numa/pooled_fixedsize_stack.hpp>
 #include <boost/fiber/numa/topology.hpp>
 #include <boost/fiber/mutex.hpp>
 #include <boost/fiber/operations.hpp>
 #include <boost/fiber/policy.hpp>
+#include <boost/fiber/pool.hpp>
 #include <boost/fiber/pooled_fixedsize_stack.hpp>
 #include <boost/fiber/properties.hpp>
 #include <boost/fiber/protected_fixedsize_stack.hpp>
@@ -34,8 +39,13 @@
 #include <boost/fiber/recursive_timed_mutex.hpp>
 #include <boost/fiber/scheduler.hpp>
 #include <boost/fiber/segmented_stack.hpp>
+#include <boost/fiber/stack_profile.hpp>
+#include <boost/fiber/stack_release.hpp>
+#include <boost/fiber/statistics.hpp>
 #include <boost/fiber/timed_mutex.hpp>
+#include <boost/fiber/trace.hpp>
 #include <boost/fiber/type.hpp>
 #include <boost/fiber/unbuffered_channel.hpp>
+#include <boost/fiber/watchdog.hpp>
 
 #endif // BOOST_FIBERS_H
@@ -0,0 +1,260 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_ARENA_FIXEDSIZE_STACK_H
+#define BOOST_FIBERS_ARENA_FIXEDSIZE_STACK_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/context/stack_context.hpp>
+#include <boost/context/stack_traits.hpp>
+#include <boost/intrusive_ptr.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/spinlock.hpp>
+
+#if defined(BOOST_USE_VALGRIND)
+#include <valgrind/valgrind.h>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+
+// pages backing the chunks of a stack arena
+enum class huge_page_policy {
+    // base pages
+    none,
+    // transparent huge pages (madvise(MADV_HUGEPAGE)), base pages if not available
+    transparent,
+    // pre-allocated huge pages (MAP_HUGETLB), transparent huge pages if not available
+    hugetlb
+};
+
+namespace detail {
+
+// size of a huge page (`0` if not supported)
+BOOST_FIBERS_DECL
+std::size_t huge_page_size() noexcept;
+
+// maps size bytes aligned to the huge page size; huge is set if
+// the memory is backed by huge pages, throws std::bad_alloc
+BOOST_FIBERS_DECL
+void * allocate_arena_chunk( std::size_t size, huge_page_policy policy, bool & huge);
+
+BOOST_FIBERS_DECL
+void deallocate_arena_chunk( void * vp, std::size_t size) noexcept;
+
+// makes [vp, vp + size) inaccessible, returns false if not supported
+BOOST_FIBERS_DECL
+bool protect_arena_guard( void * vp, std::size_t size) noexcept;
+
+}
+
+// stack allocator carving stacks of fixed size out of large chunks (arena);
+// the chunks might be backed by huge pages, thus the stacks of many fibers
+// share a few TLB entries
+// a chunk is divided into slots, a slot holds an optional guard gap (lowest
+// addresses) and a stack; slots are handed out by a bump pointer, free slots
+// are kept in a LIFO list linked through the top of the free stacks (both O(1))
+// chunks are returned to the operating system if the last copy of the
+// allocator is destroyed
+template< typename traitsT >
+class basic_arena_fixedsize_stack {
+private:
+    struct node {
+        node    *   next;
+    };
+
+    class storage {
+    private:
+        struct chunk {
+            void        *   vp;
+            std::size_t     size;
+        };
+
+        std::atomic< std::size_t >      use_count_{ 0 };
+        const std::size_t               stack_size_;
+        const std::size_t               guard_size_;
+        const std::size_t               slot_size_;
+        const huge_page_policy          policy_;
+        std::size_t                     chunk_size_;
+        detail::spinlock                splk_{};
+        std::vector< chunk >            chunks_{};
+        node                        *   free_{ nullptr };
+        // bump pointer into the most recent chunk
+        char                        *   next_{ nullptr };
+        char                        *   end_{ nullptr };
+        std::size_t                     huge_chunks_{ 0 };
+
+        static std::size_t round_up( std::size_t size, std::size_t alignment) noexcept {
+            return ( size + alignment - 1) / alignment * alignment;
+        }
+
+        // called with splk_ locked
+        char * carve_() {
+            if ( next_ == end_) {
+                chunks_.reserve( chunks_.size() + 1);
+                bool huge = false;
+                void * vp = detail::allocate_arena_chunk( chunk_size_, policy_, huge);
+                chunks_.push_back( chunk{ vp, chunk_size_ });
+                if ( huge) {
+                    ++huge_chunks_;
+                }
+                next_ = static_cast< char * >( vp);
+                end_ = next_ + chunk_size_ / slot_size_ * slot_size_;
+            }
+            char * slot = next_;
+            next_ += slot_size_;
+            return slot;
+        }
+
+    public:
+        storage( std::size_t stack_size, std::size_t guard_size,
+                 std::size_t slots_per_chunk, huge_page_policy policy) :
+            stack_size_{ round_up( stack_size, traits_type::page_size() ) },
+            guard_size_{ round_up( guard_size, traits_type::page_size() ) },
+            slot_size_{ stack_size_ + guard_size_ },
+            // protecting a guard gap splits the mapping of its huge page,
+            // thus guarded arenas use base pages
+            policy_{ 0 != guard_size_ ? huge_page_policy::none : policy },
+            chunk_size_{ slot_size_ * slots_per_chunk } {
+            BOOST_ASSERT( 0 < slots_per_chunk);
+            BOOST_ASSERT( traits_type::is_unbounded() || ( traits_type::maximum_size() >= stack_size_) );
+            const std::size_t huge_size = detail::huge_page_size();
+            if ( huge_page_policy::none != policy_ && 0 != huge_size) {
+                // chunks consist of whole huge pages
+                chunk_size_ = round_up( chunk_size_, huge_size);
+            }
+        }
+
+        ~storage() {
+            for ( chunk & c : chunks_) {
+                detail::deallocate_arena_chunk( c.vp, c.size);
+            }
+        }
+
+        std::size_t stack_size() const noexcept {
+            return stack_size_;
+        }
+
+        std::size_t chunk_count() noexcept {
+            detail::spinlock_lock lk{ splk_ };
+            return chunks_.size();
+        }
+
+        std::size_t huge_chunk_count() noexcept {
+            detail::spinlock_lock lk{ splk_ };
+            return huge_chunks_;
+        }
+
+        void * allocate() {
+            char * slot = nullptr;
+            {
+                detail::spinlock_lock lk{ splk_ };
+                if ( nullptr != free_) {
+                    node * n = free_;
+                    free_ = n->next;
+                    // the node is placed below the top of the stack
+                    return reinterpret_cast< char * >( n) + sizeof( node);
+                }
+                slot = carve_();
+            }
+            if ( 0 != guard_size_) {
+                // a slot is protected once, if it is carved
+                detail::protect_arena_guard( slot, guard_size_);
+            }
+            return slot + slot_size_;
+        }
+
+        void deallocate( void * sp) noexcept {
+            // the top of a stack is resident, the link does not fault in a page
+            node * n = reinterpret_cast< node * >( static_cast< char * >( sp) - sizeof( node) );
+            detail::spinlock_lock lk{ splk_ };
+            n->next = free_;
+            free_ = n;
+        }
+
+        friend void intrusive_ptr_add_ref( storage * s) noexcept {
+            s->use_count_.fetch_add( 1, std::memory_order_relaxed);
+        }
+
+        friend void intrusive_ptr_release( storage * s) noexcept {
+            if ( 1 == s->use_count_.fetch_sub( 1, std::memory_order_acq_rel) ) {
+                delete s;
+            }
+        }
+    };
+
+    boost::intrusive_ptr< storage >     storage_;
+
+public:
+    typedef traitsT traits_type;
+
+    // guard_size: bytes below each stack made inaccessible (`0`: no guard),
+    //             a guard disables huge pages and adds a mapping per stack
+    // slots_per_chunk: min. number of stacks carved out of a chunk
+    basic_arena_fixedsize_stack( std::size_t stack_size = traits_type::default_size(),
+                                 std::size_t guard_size = 0,
+                                 std::size_t slots_per_chunk = 256,
+                                 huge_page_policy policy = huge_page_policy::transparent) :
+        storage_{ new storage{ stack_size, guard_size, slots_per_chunk, policy } } {
+    }
+
+    boost::context::stack_context allocate() {
+        boost::context::stack_context sctx;
+        sctx.size = storage_->stack_size();
+        sctx.sp = storage_->allocate();
+#if defined(BOOST_USE_VALGRIND)
+        sctx.valgrind_stack_id = VALGRIND_STACK_REGISTER( sctx.sp, static_cast< char * >( sctx.sp) - sctx.size);
+#endif
+        return sctx;
+    }
+
+    void deallocate( boost::context::stack_context & sctx) noexcept {
+        BOOST_ASSERT( sctx.sp);
+#if defined(BOOST_USE_VALGRIND)
+        VALGRIND_STACK_DEREGISTER( sctx.valgrind_stack_id);
+#endif
+        storage_->deallocate( sctx.sp);
+    }
+
+    // number of chunks mapped by the arena
+    std::size_t chunk_count() const noexcept {
+        return storage_->chunk_count();
+    }
+
+    // number of chunks backed by huge pages
+    std::size_t huge_chunk_count() const noexcept {
+        return storage_->huge_chunk_count();
+    }
+
+    // copies share the arena
+    friend bool operator==( basic_arena_fixedsize_stack const& l, basic_arena_fixedsize_stack const& r) noexcept {
+        return l.storage_ == r.storage_;
+    }
+
+    friend bool operator!=( basic_arena_fixedsize_stack const& l, basic_arena_fixedsize_stack const& r) noexcept {
+        return l.storage_ != r.storage_;
+    }
+};
+
+using arena_fixedsize_stack = basic_arena_fixedsize_stack< boost::context::stack_traits >;
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_ARENA_FIXEDSIZE_STACK_H
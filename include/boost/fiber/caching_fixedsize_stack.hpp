@@ -0,0 +1,356 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_CACHING_FIXEDSIZE_STACK_H
+#define BOOST_FIBERS_CACHING_FIXEDSIZE_STACK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/context/stack_context.hpp>
+#include <boost/context/stack_traits.hpp>
+#include <boost/intrusive_ptr.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/stack_cache.hpp>
+#include <boost/fiber/stack_release.hpp>
+
+#if defined(BOOST_USE_VALGRIND)
+#include <valgrind/valgrind.h>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+
+// stack allocator with a cache of free stacks per thread: a stack is
+// taken from and returned to the cache of the calling thread, thus
+// a fiber stolen by another thread returns its stack to the cache of
+// that thread
+// if a cache exceeds cache_size stacks, the coldest half is moved as one
+// batch to a depot shared by all threads; the depot is an array of
+// depot_size slots, each claimed by one CAS (no locks, no ABA) - a
+// thread with an empty cache takes a whole batch from the depot
+// if the depot is full, the batch is deallocated
+// a free stack stores the link to the next free stack at its lowest address
+// the cold part of free stacks might be returned to the operating system
+// (stack_release_policy): stacks deeper than `hysteresis` in the cache of a
+// thread and stacks moved to the depot are released
+template< typename traitsT >
+class basic_caching_fixedsize_stack {
+private:
+    struct node {
+        node            *   next;
+        // length of the batch, valid at the head of a batch in the depot
+        std::size_t         count;
+        // pages released while the stack is free
+        bool                released;
+    };
+
+    class storage {
+    private:
+        std::atomic< std::size_t >                      use_count_{ 0 };
+        const std::size_t                               stack_size_;
+        const std::size_t                               cache_size_;
+        const std::size_t                               depot_size_;
+        const stack_release_policy                      release_;
+        std::unique_ptr< std::atomic< node * >[] >      depot_;
+
+    public:
+        storage( std::size_t stack_size, std::size_t cache_size, std::size_t depot_size,
+                 stack_release_policy const& release) :
+            stack_size_{ stack_size },
+            cache_size_{ cache_size },
+            depot_size_{ depot_size },
+            release_( release),
+            depot_{ new std::atomic< node * >[depot_size] } {
+            BOOST_ASSERT( sizeof( node) < stack_size_);
+            BOOST_ASSERT( traits_type::is_unbounded() || ( traits_type::maximum_size() >= stack_size_) );
+            for ( std::size_t i = 0; i < depot_size_; ++i) {
+                depot_[i].store( nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        ~storage() {
+            for ( std::size_t i = 0; i < depot_size_; ++i) {
+                deallocate_batch( depot_[i].load( std::memory_order_relaxed) );
+            }
+        }
+
+        std::size_t stack_size() const noexcept {
+            return stack_size_;
+        }
+
+        std::size_t cache_size() const noexcept {
+            return cache_size_;
+        }
+
+        stack_release_policy const& release_policy() const noexcept {
+            return release_;
+        }
+
+        // the stack must be owned by the calling thread
+        void release( node * n) noexcept {
+            if ( ! n->released) {
+                n->released = true;
+                detail::release_stack_memory(
+                        reinterpret_cast< char * >( n) + sizeof( node),
+                        reinterpret_cast< char * >( n) + stack_size_,
+                        release_.watermark, release_.lazy);
+            }
+        }
+
+        void * allocate_memory() {
+            void * vp = std::malloc( stack_size_);
+            if ( nullptr == vp) {
+                throw std::bad_alloc();
+            }
+            return vp;
+        }
+
+        static void deallocate_batch( node * n) noexcept {
+            while ( nullptr != n) {
+                node * next = n->next;
+                std::free( n);
+                n = next;
+            }
+        }
+
+        // returns false if all slots of the depot are occupied
+        bool push_batch( node * batch) noexcept {
+            for ( std::size_t i = 0; i < depot_size_; ++i) {
+                node * expected = nullptr;
+                if ( nullptr == depot_[i].load( std::memory_order_relaxed) &&
+                     depot_[i].compare_exchange_strong( expected, batch,
+                                                        std::memory_order_release,
+                                                        std::memory_order_relaxed) ) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        node * pop_batch() noexcept {
+            for ( std::size_t i = 0; i < depot_size_; ++i) {
+                if ( nullptr != depot_[i].load( std::memory_order_relaxed) ) {
+                    node * batch = depot_[i].exchange( nullptr, std::memory_order_acquire);
+                    if ( nullptr != batch) {
+                        return batch;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        // moves count stacks starting at head to the depot
+        void flush( node * head, std::size_t count) noexcept {
+            if ( nullptr == head) {
+                return;
+            }
+            if ( release_.enabled) {
+                // stacks in the depot are cold
+                for ( node * n = head; nullptr != n; n = n->next) {
+                    release( n);
+                }
+            }
+            head->count = count;
+            if ( ! push_batch( head) ) {
+                deallocate_batch( head);
+            }
+        }
+
+        std::size_t use_count() const noexcept {
+            return use_count_.load( std::memory_order_relaxed);
+        }
+
+        friend void intrusive_ptr_add_ref( storage * s) noexcept {
+            s->use_count_.fetch_add( 1, std::memory_order_relaxed);
+        }
+
+        friend void intrusive_ptr_release( storage * s) noexcept {
+            if ( 1 == s->use_count_.fetch_sub( 1, std::memory_order_acq_rel) ) {
+                delete s;
+            }
+        }
+    };
+
+    // free stacks of one storage cached by the current thread,
+    // the entry keeps the storage alive
+    struct cache_entry {
+        boost::intrusive_ptr< storage >     s;
+        node                            *   head;
+        std::size_t                         count;
+    };
+
+    struct thread_cache {
+        std::vector< cache_entry >          entries{};
+        bool                            &   destroyed;
+
+        explicit thread_cache( bool & destroyed_) noexcept :
+            destroyed( destroyed_) {
+        }
+
+        ~thread_cache() {
+            destroyed = true;
+            for ( cache_entry & e : entries) {
+                e.s->flush( e.head, e.count);
+            }
+        }
+
+        cache_entry & get( storage * s) {
+            for ( cache_entry & e : entries) {
+                if ( e.s.get() == s) {
+                    return e;
+                }
+            }
+            // release storages no longer referenced by an allocator
+            for ( typename std::vector< cache_entry >::iterator i = entries.begin(); i != entries.end(); ) {
+                if ( 1 == i->s->use_count() ) {
+                    i->s->flush( i->head, i->count);
+                    i = entries.erase( i);
+                } else {
+                    ++i;
+                }
+            }
+            entries.push_back( cache_entry{ s, nullptr, 0 });
+            return entries.back();
+        }
+    };
+
+    // nullptr if the cache of the current thread has already been
+    // destroyed (fibers released by thread-local destructors)
+    static thread_cache * local_cache_() {
+        static thread_local bool destroyed = false;
+        if ( destroyed) {
+            return nullptr;
+        }
+        static thread_local thread_cache cache{ destroyed };
+        return & cache;
+    }
+
+    boost::intrusive_ptr< storage >     storage_;
+
+public:
+    typedef traitsT traits_type;
+
+    // cache_size: max. number of free stacks cached per thread
+    // depot_size: max. number of batches held by the depot
+    basic_caching_fixedsize_stack( std::size_t stack_size = traits_type::default_size(),
+                                   std::size_t cache_size = 16,
+                                   std::size_t depot_size = 64,
+                                   stack_release_policy const& release = stack_release_policy{}) :
+        storage_{ new storage{ stack_size, cache_size, depot_size, release } } {
+    }
+
+    boost::context::stack_context allocate() {
+        void * vp = nullptr;
+        thread_cache * cache = local_cache_();
+        if ( nullptr != cache) {
+            cache_entry & e = cache->get( storage_.get() );
+            if ( nullptr == e.head) {
+                e.head = storage_->pop_batch();
+                e.count = nullptr != e.head ? e.head->count : 0;
+            }
+            if ( nullptr != e.head) {
+                vp = e.head;
+                e.head = e.head->next;
+                --e.count;
+                static_cast< node * >( vp)->released = false;
+            }
+        }
+        if ( nullptr == vp) {
+            vp = storage_->allocate_memory();
+        }
+        boost::context::stack_context sctx;
+        sctx.size = storage_->stack_size();
+        sctx.sp = static_cast< char * >( vp) + sctx.size;
+#if defined(BOOST_USE_VALGRIND)
+        sctx.valgrind_stack_id = VALGRIND_STACK_REGISTER( sctx.sp, vp);
+#endif
+        return sctx;
+    }
+
+    void deallocate( boost::context::stack_context & sctx) noexcept {
+        BOOST_ASSERT( sctx.sp);
+#if defined(BOOST_USE_VALGRIND)
+        VALGRIND_STACK_DEREGISTER( sctx.valgrind_stack_id);
+#endif
+        node * n = reinterpret_cast< node * >( static_cast< char * >( sctx.sp) - sctx.size);
+        n->next = nullptr;
+        n->released = false;
+        thread_cache * cache = local_cache_();
+        cache_entry * e = nullptr;
+        if ( nullptr != cache) {
+            try {
+                e = & cache->get( storage_.get() );
+            } catch (...) {
+            }
+        }
+        if ( nullptr == e) {
+            storage_->flush( n, 1);
+            return;
+        }
+        // LIFO, the most recently used stack is hot in the cache
+        n->next = e->head;
+        e->head = n;
+        ++e->count;
+        stack_release_policy const& release = storage_->release_policy();
+        if ( release.enabled && e->count > release.hysteresis) {
+            // the stack falling out of the hot range of the cache is released
+            node * cold = e->head;
+            for ( std::size_t i = 0; i < release.hysteresis; ++i) {
+                cold = cold->next;
+            }
+            storage_->release( cold);
+        }
+        if ( e->count > storage_->cache_size() ) {
+            // keep the hot half, move the cold half to the depot
+            const std::size_t keep = storage_->cache_size() / 2;
+            node * batch = e->head;
+            if ( 0 < keep) {
+                node * last = e->head;
+                for ( std::size_t i = 1; i < keep; ++i) {
+                    last = last->next;
+                }
+                batch = last->next;
+                last->next = nullptr;
+            } else {
+                e->head = nullptr;
+            }
+            storage_->flush( batch, e->count - keep);
+            e->count = keep;
+        }
+    }
+};
+
+using caching_fixedsize_stack = basic_caching_fixedsize_stack< boost::context::stack_traits >;
+
+namespace detail {
+
+// stacks are cached per thread by the allocator itself
+template< typename traitsT >
+struct is_stack_cacheable< basic_caching_fixedsize_stack< traitsT > > : public std::false_type {
+};
+
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_CACHING_FIXEDSIZE_STACK_H
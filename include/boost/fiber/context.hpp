@@ -17,6 +17,7 @@
 #include <memory>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 #include <boost/assert.hpp>
 #include <boost/config.hpp>
@@ -36,11 +37,14 @@
 #include <boost/fiber/detail/decay_copy.hpp>
 #include <boost/fiber/detail/fss.hpp>
 #include <boost/fiber/detail/spinlock.hpp>
+#include <boost/fiber/detail/stack_cache.hpp>
 #include <boost/fiber/exceptions.hpp>
 #include <boost/fiber/fixedsize_stack.hpp>
+#include <boost/fiber/numa/memory.hpp>
 #include <boost/fiber/policy.hpp>
 #include <boost/fiber/properties.hpp>
 #include <boost/fiber/segmented_stack.hpp>
+#include <boost/fiber/stack_profile.hpp>
 #include <boost/fiber/type.hpp>
 
 #ifdef BOOST_HAS_ABI_HEADERS
@@ -61,6 +65,9 @@ class scheduler;
 
 namespace detail {
 
+class context_mpsc_queue;
+class timer_wheel;
+
 struct wait_tag;
 typedef intrusive::list_member_hook<
     intrusive::tag< wait_tag >,
@@ -102,6 +109,14 @@ typedef intrusive::set_member_hook<
     >
 >                                       sleep_hook;
 
+struct sleep_wheel_tag;
+typedef intrusive::list_member_hook<
+    intrusive::tag< sleep_wheel_tag >,
+    intrusive::link_mode<
+        intrusive::auto_unlink
+    >
+>                                       sleep_wheel_hook;
+
 struct worker_tag;
 typedef intrusive::list_member_hook<
     intrusive::tag< worker_tag >,
@@ -118,13 +133,22 @@ typedef intrusive::slist_member_hook<
     >
 >                                       terminated_hook;
 
-struct remote_ready_tag;
-typedef intrusive::slist_member_hook<
-    intrusive::tag< remote_ready_tag >,
-    intrusive::link_mode<
-        intrusive::safe_link
-    >
->                                       remote_ready_hook;
+// hook of the lock-free remote ready-queue (context_mpsc_queue)
+// an unlinked hook points to itself
+struct remote_ready_hook {
+    std::atomic< remote_ready_hook * >  next;
+
+    remote_ready_hook() noexcept :
+        next{ this } {
+    }
+
+    remote_ready_hook( remote_ready_hook const&) = delete;
+    remote_ready_hook & operator=( remote_ready_hook const&) = delete;
+
+    bool is_linked() const noexcept {
+        return this != next.load( std::memory_order_relaxed);
+    }
+};
 
 }
 
@@ -141,18 +165,24 @@ private:
     friend class main_context;
     template< typename Fn, typename ... Arg > friend class worker_context;
     friend class scheduler;
+    friend class detail::context_mpsc_queue;
+    friend class detail::timer_wheel;
 
     struct fss_data {
         void                                *   vp{ nullptr };
         detail::fss_cleanup_function::ptr_t     cleanup_function{};
+        // generation of the fss_key, 0 if unused
+        std::size_t                             generation{ 0 };
 
         fss_data() noexcept {
         }
 
         fss_data( void * vp_,
-                  detail::fss_cleanup_function::ptr_t const& fn) noexcept :
+                  detail::fss_cleanup_function::ptr_t const& fn,
+                  std::size_t generation_) noexcept :
             vp( vp_),
-            cleanup_function( fn) {
+            cleanup_function( fn),
+            generation( generation_) {
             BOOST_ASSERT( cleanup_function);
         }
 
@@ -161,7 +191,9 @@ private:
         }
     };
 
-    typedef std::map< uintptr_t, fss_data >             fss_data_t;
+    // fiber-specific values indexed by fss_key::index, the first
+    // BOOST_FIBERS_FSS_INLINE_SIZE values are stored inline
+    typedef std::vector< fss_data >                     fss_data_t;
 
 #if ! defined(BOOST_FIBERS_NO_ATOMICS)
     std::atomic< std::size_t >                          use_count_;
@@ -179,16 +211,30 @@ public:
 #if ! defined(BOOST_FIBERS_NO_ATOMICS)
     std::atomic< std::intptr_t >                        twstatus{ 0 };
 #endif
+    // maintained by numa::work_stealing: NUMA node the stack memory
+    // is located on (the node announced by the thread creating the fiber,
+    // numa::unknown_node if not announced) and count of consecutive picks
+    // on other nodes
+    std::uint32_t                                       numa_node{ numa::unknown_node };
+    std::uint32_t                                       numa_remote_picks{ 0 };
 private:
     scheduler                                       *   scheduler_{ nullptr };
-    fss_data_t                                          fss_data_{};
+    fss_data                                            fss_inline_[BOOST_FIBERS_FSS_INLINE_SIZE]{};
+    fss_data_t                                          fss_overflow_{};
     detail::sleep_hook                                  sleep_hook_{};
+    detail::sleep_wheel_hook                            sleep_wheel_hook_{};
     detail::ready_hook                                  ready_hook_{};
     detail::terminated_hook                             terminated_hook_{};
     detail::worker_hook                                 worker_hook_{};
     fiber_properties                                *   properties_{ nullptr };
     std::chrono::steady_clock::time_point               tp_{ (std::chrono::steady_clock::time_point::max)() };
     boost::context::continuation                        c_{};
+    // stack memory of a worker-context, the context is
+    // placed at the top of the stack
+    void                                            *   stack_bottom_{ nullptr };
+    void                                            *   stack_top_{ nullptr };
+    // set if the stack has been filled for profiling
+    detail::stack_profile_site const                *   stack_site_{ nullptr };
     type                                                type_;
     launch                                              policy_;
 
@@ -200,6 +246,10 @@ private:
 
     void resume_( detail::data_t &) noexcept;
 
+    fss_data & fss_slot_( std::size_t);
+
+    void release_fss_data_();
+
 public:
     class id {
     private:
@@ -304,10 +354,21 @@ public:
         return type::none != ( type_ & t);
     }
 
-    void * get_fss_data( void const * vp) const;
+    void * get_fss_data( detail::fss_key const& key) const noexcept {
+        fss_data const* d = nullptr;
+        if ( BOOST_LIKELY( key.index < BOOST_FIBERS_FSS_INLINE_SIZE) ) {
+            d = & fss_inline_[key.index];
+        } else if ( key.index - BOOST_FIBERS_FSS_INLINE_SIZE < fss_overflow_.size() ) {
+            d = & fss_overflow_[key.index - BOOST_FIBERS_FSS_INLINE_SIZE];
+        } else {
+            return nullptr;
+        }
+        // values of a destroyed fiber_specific_ptr are not visible
+        return key.generation == d->generation ? d->vp : nullptr;
+    }
 
     void set_fss_data(
-        void const * vp,
+        detail::fss_key const& key,
         detail::fss_cleanup_function::ptr_t const& cleanup_fn,
         void * data,
         bool cleanup_existing);
@@ -322,6 +383,15 @@ public:
         return policy_;
     }
 
+    // nullptr if not a worker-context
+    void * get_stack_bottom() const noexcept {
+        return stack_bottom_;
+    }
+
+    void * get_stack_top() const noexcept {
+        return stack_top_;
+    }
+
     bool worker_is_linked() const noexcept;
 
     bool ready_is_linked() const noexcept;
@@ -348,13 +418,6 @@ public:
         lst.push_back( * this);
     }
 
-    template< typename List >
-    void remote_ready_link( List & lst) noexcept {
-        static_assert( std::is_same< typename List::value_traits::hook_type, detail::remote_ready_hook >::value, "not a remote-ready-queue");
-        BOOST_ASSERT( ! remote_ready_is_linked() );
-        lst.push_back( * this);
-    }
-
     template< typename Set >
     void sleep_link( Set & set) noexcept {
         static_assert( std::is_same< typename Set::value_traits::hook_type,detail::sleep_hook >::value, "not a sleep-queue");
@@ -445,10 +508,14 @@ public:
     template< typename StackAlloc >
     worker_context( launch policy,
                     boost::context::preallocated const& palloc, StackAlloc const& salloc,
+                    detail::stack_profile_site const* site,
                     Fn && fn, Arg ... arg) :
             context{ 1, type::worker_context, policy },
             fn_( std::forward< Fn >( fn) ),
             arg_( std::forward< Arg >( arg) ... ) {
+        stack_bottom_ = static_cast< char * >( palloc.sctx.sp) - palloc.sctx.size;
+        stack_top_ = palloc.sctx.sp;
+        stack_site_ = site;
         c_ = boost::context::callcc(
                 std::allocator_arg, palloc, salloc,
                 std::bind( & worker_context::run_, this, std::placeholders::_1) );
@@ -462,7 +529,12 @@ static intrusive_ptr< context > make_worker_context( launch policy,
                                                      Fn && fn, Arg ... arg) {
     typedef worker_context< Fn, Arg ... >   context_t;
 
-    auto sctx = salloc.allocate();
+    // reuse a stack of a terminated fiber if available,
+    // the stack is returned to the cache on termination
+    detail::cached_stack_allocator< StackAlloc > csalloc{ salloc };
+    auto sctx = csalloc.allocate();
+    // fill the stack before the context is placed on top
+    detail::stack_profile_site const* site = detail::prepare_stack_profile< StackAlloc >( sctx);
     // reserve space for control structure
     void * storage = reinterpret_cast< void * >(
             ( reinterpret_cast< uintptr_t >( sctx.sp) - static_cast< uintptr_t >( sizeof( context_t) ) )
@@ -471,13 +543,18 @@ static intrusive_ptr< context > make_worker_context( launch policy,
             reinterpret_cast< uintptr_t >( sctx.sp) - static_cast< uintptr_t >( sctx.size) );
     const std::size_t size = reinterpret_cast< uintptr_t >( storage) - reinterpret_cast< uintptr_t >( stack_bottom);
     // placement new of context on top of fiber's stack
-    return intrusive_ptr< context >{ 
+    intrusive_ptr< context > ctx{ 
             new ( storage) context_t{
                 policy,
                 boost::context::preallocated{ storage, size, sctx },
-                salloc,
+                csalloc,
+                site,
                 std::forward< Fn >( fn),
                 std::forward< Arg >( arg) ... } };
+    // the top of the stack has been touched by this thread (first-touch),
+    // unknown if this thread is not bound to a NUMA node
+    ctx->numa_node = numa::announced_node();
+    return ctx;
 }
 
 namespace detail {
@@ -63,4 +63,41 @@
 # define BOOST_FIBERS_SPIN_BEFORE_YIELD 64
 #endif
 
+#if !defined(BOOST_FIBERS_TIMER_WHEEL_RESOLUTION)
+// microseconds
+# define BOOST_FIBERS_TIMER_WHEEL_RESOLUTION 1000
+#endif
+
+#if !defined(BOOST_FIBERS_PINNED_WAIT_MAX)
+// max. number of fibers picked by a work-stealing scheduler
+// before a pending main- or dispatcher-context
+# define BOOST_FIBERS_PINNED_WAIT_MAX 16
+#endif
+
+#if !defined(BOOST_FIBERS_STACK_CACHE_MAX_COUNT)
+// max. number of stacks cached per scheduler (`0`: disabled)
+# define BOOST_FIBERS_STACK_CACHE_MAX_COUNT 0
+#endif
+
+#if !defined(BOOST_FIBERS_STACK_CACHE_MAX_BYTES)
+// max. bytes of stacks cached per scheduler
+# define BOOST_FIBERS_STACK_CACHE_MAX_BYTES 0
+#endif
+
+#if !defined(BOOST_FIBERS_TRACE_BUFFER_SIZE)
+// events per thread, power of two
+# define BOOST_FIBERS_TRACE_BUFFER_SIZE 65536
+#endif
+
+#if !defined(BOOST_FIBERS_POOL_QUEUE_CAPACITY)
+// tasks queued by boost::fibers::pool, power of two
+# define BOOST_FIBERS_POOL_QUEUE_CAPACITY 1024
+#endif
+
+#if !defined(BOOST_FIBERS_FSS_INLINE_SIZE)
+// fiber-specific values stored inside the context,
+// further values are stored on the heap
+# define BOOST_FIBERS_FSS_INLINE_SIZE 4
+#endif
+
 #endif // BOOST_FIBERS_DETAIL_CONFIG_H
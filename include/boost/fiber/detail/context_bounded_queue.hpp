@@ -0,0 +1,197 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_DETAIL_CONTEXT_BOUNDED_QUEUE_H
+#define BOOST_FIBERS_DETAIL_CONTEXT_BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+
+#include <boost/fiber/context.hpp>
+#include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/context_spinlock_queue.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+// ring of fixed capacity as the local run-queues of the Go runtime:
+// the owner pushes at the tail, the owner and the thieves claim
+// contexts at the head via CAS; if the ring is full, half of its
+// contexts are spilled to an overflow queue shared by all schedulers
+// (memory of the ring is never grown)
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+class context_bounded_queue {
+public:
+    // max. number of contexts moved by steal_half()
+    static constexpr std::size_t max_steal_batch = 32;
+
+private:
+    typedef std::atomic< context * >    slot_type;
+
+    std::atomic< std::size_t >          head_{ 0 };
+    char                                pad_[cacheline_length];
+    std::atomic< std::size_t >          tail_{ 0 };
+    const std::size_t                   capacity_;
+    std::unique_ptr< slot_type[] >      slots_;
+    context_spinlock_queue          &   overflow_;
+
+    context * load_( std::size_t idx) const noexcept {
+        return slots_[idx % capacity_].load( std::memory_order_relaxed);
+    }
+
+    // moves half of the contexts and ctx to the overflow queue,
+    // fails if a thief has claimed contexts in the meantime
+    // (called by the owner, thus the claimed slots are not
+    // overwritten before they have been read)
+    bool spill_( context * ctx, std::size_t & head, std::size_t tail) {
+        const std::size_t count = ( tail - head) / 2;
+        if ( ! head_.compare_exchange_strong( head, head + count,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_relaxed) ) {
+            return false;
+        }
+        for ( std::size_t i = 0; i < count; ++i) {
+            overflow_.push( load_( head + i) );
+        }
+        overflow_.push( ctx);
+        head += count;
+        return true;
+    }
+
+public:
+    context_bounded_queue( context_spinlock_queue & overflow, std::size_t capacity = 256) :
+        capacity_{ capacity },
+        slots_{ new slot_type[capacity] },
+        overflow_( overflow) {
+        BOOST_ASSERT( 1 < capacity_);
+        for ( std::size_t i = 0; i < capacity_; ++i) {
+            slots_[i].store( nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    context_bounded_queue( context_bounded_queue const&) = delete;
+    context_bounded_queue & operator=( context_bounded_queue const&) = delete;
+
+    bool empty() const noexcept {
+        return head_.load( std::memory_order_relaxed) == tail_.load( std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    // approximation if called concurrently to steal()
+    std::size_t size() const noexcept {
+        const std::size_t head = head_.load( std::memory_order_relaxed);
+        const std::size_t tail = tail_.load( std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    // returns the number of contexts queued in the ring after the push
+    // (approximation if called concurrently to steal())
+    std::size_t push( context * ctx) {
+        for (;;) {
+            std::size_t head = head_.load( std::memory_order_acquire);
+            const std::size_t tail = tail_.load( std::memory_order_relaxed);
+            if ( tail - head < capacity_) {
+                slots_[tail % capacity_].store( ctx, std::memory_order_relaxed);
+                tail_.store( tail + 1, std::memory_order_release);
+                return tail + 1 - head;
+            }
+            // ring is full
+            if ( spill_( ctx, head, tail) ) {
+                return tail - head;
+            }
+        }
+    }
+
+    context * pop() noexcept {
+        std::size_t head = head_.load( std::memory_order_acquire);
+        for (;;) {
+            const std::size_t tail = tail_.load( std::memory_order_relaxed);
+            if ( head == tail) {
+                return nullptr;
+            }
+            context * ctx = load_( head);
+            if ( head_.compare_exchange_weak( head, head + 1,
+                                              std::memory_order_release,
+                                              std::memory_order_acquire) ) {
+                return ctx;
+            }
+        }
+    }
+
+    context * steal() noexcept {
+        std::size_t head = head_.load( std::memory_order_acquire);
+        const std::size_t tail = tail_.load( std::memory_order_acquire);
+        if ( head == tail || tail - head > capacity_) {
+            // empty or inconsistent snapshot
+            return nullptr;
+        }
+        context * ctx = load_( head);
+        // pinned contexts are never pushed
+        BOOST_ASSERT( ! ctx->is_context( type::pinned_context) );
+        if ( ! head_.compare_exchange_strong( head, head + 1,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed) ) {
+            // lose the race
+            return nullptr;
+        }
+        return ctx;
+    }
+
+    // steals up to half of the contexts (at most max_steal_batch) with
+    // one CAS; the first context is returned, the others are pushed
+    // to dst, which must be owned by the calling thread
+    context * steal_half( context_bounded_queue & dst) {
+        std::size_t head = head_.load( std::memory_order_acquire);
+        const std::size_t tail = tail_.load( std::memory_order_acquire);
+        if ( head == tail || tail - head > capacity_) {
+            // empty or inconsistent snapshot
+            return nullptr;
+        }
+        std::size_t count = ( tail - head + 1) / 2;
+        if ( max_steal_batch < count) {
+            count = max_steal_batch;
+        }
+        context * batch[max_steal_batch];
+        for ( std::size_t i = 0; i < count; ++i) {
+            batch[i] = load_( head + i);
+            BOOST_ASSERT( ! batch[i]->is_context( type::pinned_context) );
+        }
+        if ( ! head_.compare_exchange_strong( head, head + count,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed) ) {
+            // lose the race
+            return nullptr;
+        }
+        for ( std::size_t i = 1; i < count; ++i) {
+            dst.push( batch[i]);
+        }
+        return batch[0];
+    }
+
+    // memory of the ring is fixed
+    void shrink() noexcept {
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_DETAIL_CONTEXT_BOUNDED_QUEUE_H
@@ -0,0 +1,125 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_DETAIL_CONTEXT_MPSC_QUEUE_H
+#define BOOST_FIBERS_DETAIL_CONTEXT_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/intrusive/parent_from_member.hpp>
+
+#include <boost/fiber/context.hpp>
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+// Dmitry Vyukov. Intrusive MPSC node-based queue.
+// http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+// multi-producer/single-consumer queue linking context'
+// via context::remote_ready_hook_
+// push() is wait-free, pop() is lock-free but might return nullptr
+// while a producer is between its two stores; the producer notifies
+// the consumer afterwards (algorithm::notify())
+class context_mpsc_queue {
+private:
+    // written by producers
+    std::atomic< remote_ready_hook * >      head_;
+    char                                    pad_head_[cacheline_length];
+    // accessed only by the consumer
+    remote_ready_hook                   *   tail_;
+    remote_ready_hook                       stub_{};
+    char                                    pad_tail_[cacheline_length];
+
+    static context * to_context_( remote_ready_hook * hook) noexcept {
+        return intrusive::get_parent_from_member< context >( hook, & context::remote_ready_hook_);
+    }
+
+    void push_( remote_ready_hook * hook) noexcept {
+        hook->next.store( nullptr, std::memory_order_relaxed);
+        remote_ready_hook * prev = head_.exchange( hook, std::memory_order_acq_rel);
+        prev->next.store( hook, std::memory_order_release);
+    }
+
+    static context * unlink_( remote_ready_hook * hook) noexcept {
+        // the next-pointer of a dequeued hook is not written by producers
+        hook->next.store( hook, std::memory_order_relaxed);
+        return to_context_( hook);
+    }
+
+public:
+    context_mpsc_queue() noexcept :
+        head_{ & stub_ },
+        tail_{ & stub_ } {
+        stub_.next.store( nullptr, std::memory_order_relaxed);
+    }
+
+    context_mpsc_queue( context_mpsc_queue const&) = delete;
+    context_mpsc_queue & operator=( context_mpsc_queue const&) = delete;
+
+    // might be called concurrently by multiple threads
+    void push( context * ctx) noexcept {
+        BOOST_ASSERT( nullptr != ctx);
+        BOOST_ASSERT( ! ctx->remote_ready_is_linked() );
+        push_( & ctx->remote_ready_hook_);
+    }
+
+    // must be called only by the thread owning the queue
+    context * pop() noexcept {
+        remote_ready_hook * tail = tail_;
+        remote_ready_hook * next = tail->next.load( std::memory_order_acquire);
+        if ( & stub_ == tail) {
+            if ( nullptr == next) {
+                // queue is empty
+                return nullptr;
+            }
+            // skip stub
+            tail_ = next;
+            tail = next;
+            next = next->next.load( std::memory_order_acquire);
+        }
+        if ( nullptr != next) {
+            tail_ = next;
+            return unlink_( tail);
+        }
+        if ( tail != head_.load( std::memory_order_acquire) ) {
+            // a producer has not yet linked its hook
+            return nullptr;
+        }
+        // tail is the last hook, re-insert stub in order
+        // to dequeue it
+        push_( & stub_);
+        next = tail->next.load( std::memory_order_acquire);
+        if ( nullptr != next) {
+            tail_ = next;
+            return unlink_( tail);
+        }
+        return nullptr;
+    }
+
+    // must be called only by the thread owning the queue
+    // reads head_, thus a hook that is concurrently pushed
+    // counts as enqueued even if it is not yet linked
+    bool empty() const noexcept {
+        return & stub_ == tail_ && & stub_ == head_.load( std::memory_order_acquire);
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_DETAIL_CONTEXT_MPSC_QUEUE_H
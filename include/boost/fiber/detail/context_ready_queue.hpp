@@ -0,0 +1,169 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_DETAIL_CONTEXT_READY_QUEUE_H
+#define BOOST_FIBERS_DETAIL_CONTEXT_READY_QUEUE_H
+
+#include <cstddef>
+#include <memory>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+
+#include <boost/fiber/context.hpp>
+#include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/context_bounded_queue.hpp>
+#include <boost/fiber/detail/context_spinlock_queue.hpp>
+#include <boost/fiber/detail/context_spmc_queue.hpp>
+#include <boost/fiber/policy.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+// ready-queue of a work-stealing scheduler, the implementation is
+// selected at runtime (ready_queue_policy); all queues of a stealing
+// domain apply the same policy, thus steal_half() moves contexts
+// between queues of the same kind
+class context_ready_queue {
+private:
+    ready_queue_policy                          policy_{ ready_queue_policy::spinlock };
+    std::unique_ptr< context_spinlock_queue >   spinlock_{};
+    std::unique_ptr< context_spmc_queue >       spmc_{};
+    std::unique_ptr< context_bounded_queue >    bounded_{};
+
+public:
+    context_ready_queue() = default;
+
+    context_ready_queue( context_ready_queue const&) = delete;
+    context_ready_queue & operator=( context_ready_queue const&) = delete;
+
+    // called once by the domain before the queue is used; contexts
+    // spilled by a bounded queue are pushed to overflow
+    void reset( ready_queue_policy policy, context_spinlock_queue & overflow) {
+        policy_ = policy;
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            spmc_.reset( new context_spmc_queue{} );
+            break;
+        case ready_queue_policy::bounded:
+            bounded_.reset( new context_bounded_queue{ overflow } );
+            break;
+        default:
+            spinlock_.reset( new context_spinlock_queue{} );
+            break;
+        }
+    }
+
+    ready_queue_policy policy() const noexcept {
+        return policy_;
+    }
+
+    bool empty() const noexcept {
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            return spmc_->empty();
+        case ready_queue_policy::bounded:
+            return bounded_->empty();
+        default:
+            return spinlock_->empty();
+        }
+    }
+
+    std::size_t capacity() const noexcept {
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            return spmc_->capacity();
+        case ready_queue_policy::bounded:
+            return bounded_->capacity();
+        default:
+            return spinlock_->capacity();
+        }
+    }
+
+    std::size_t size() const noexcept {
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            return spmc_->size();
+        case ready_queue_policy::bounded:
+            return bounded_->size();
+        default:
+            return spinlock_->size();
+        }
+    }
+
+    // returns the number of contexts queued after the push
+    std::size_t push( context * ctx) {
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            return spmc_->push( ctx);
+        case ready_queue_policy::bounded:
+            return bounded_->push( ctx);
+        default:
+            return spinlock_->push( ctx);
+        }
+    }
+
+    context * pop() {
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            return spmc_->pop();
+        case ready_queue_policy::bounded:
+            return bounded_->pop();
+        default:
+            return spinlock_->pop();
+        }
+    }
+
+    context * steal() {
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            return spmc_->steal();
+        case ready_queue_policy::bounded:
+            return bounded_->steal();
+        default:
+            return spinlock_->steal();
+        }
+    }
+
+    context * steal_half( context_ready_queue & dst) {
+        BOOST_ASSERT( policy_ == dst.policy_);
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            return spmc_->steal_half( * dst.spmc_);
+        case ready_queue_policy::bounded:
+            return bounded_->steal_half( * dst.bounded_);
+        default:
+            return spinlock_->steal_half( * dst.spinlock_);
+        }
+    }
+
+    void shrink() {
+        switch ( policy_) {
+        case ready_queue_policy::spmc:
+            spmc_->shrink();
+            break;
+        case ready_queue_policy::bounded:
+            bounded_->shrink();
+            break;
+        default:
+            spinlock_->shrink();
+            break;
+        }
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_DETAIL_CONTEXT_READY_QUEUE_H
@@ -8,10 +8,12 @@
 #ifndef BOOST_FIBERS_DETAIL_SPINLOCK_QUEUE_H
 #define BOOST_FIBERS_DETAIL_SPINLOCK_QUEUE_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <mutex>
 
+#include <boost/assert.hpp>
 #include <boost/config.hpp>
 
 #include <boost/fiber/context.hpp>
@@ -27,6 +29,10 @@ namespace fibers {
 namespace detail {
 
 class context_spinlock_queue {
+public:
+    // max. number of contexts moved by steal_half()
+    static constexpr std::size_t max_steal_batch = 32;
+
 private:
 	typedef context *   slot_type;
 
@@ -34,7 +40,15 @@ private:
 	std::size_t                                 pidx_{ 0 };
 	std::size_t                                 cidx_{ 0 };
 	std::size_t                                 capacity_;
+	const std::size_t                           min_capacity_;
 	slot_type                               *   slots_;
+    // number of queued contexts, written under splk_; read without
+    // the lock, thus probing an empty queue does not take the lock
+    std::atomic< std::size_t >                  count_{ 0 };
+
+    void update_count_() noexcept {
+        count_.store( ( pidx_ + capacity_ - cidx_) % capacity_, std::memory_order_relaxed);
+    }
 
 	void resize_() {
 		slot_type * old_slots = slots_;
@@ -60,7 +74,8 @@ private:
 
 public:
 	context_spinlock_queue( std::size_t capacity = 4096) :
-			capacity_{ capacity } {
+			capacity_{ capacity },
+			min_capacity_{ capacity } {
 		slots_ = new slot_type[capacity_];
 	}
 
@@ -72,41 +87,111 @@ public:
     context_spinlock_queue & operator=( context_spinlock_queue const&) = delete;
 
 	bool empty() const noexcept {
+		return 0 == count_.load( std::memory_order_relaxed);
+	}
+
+	std::size_t capacity() const noexcept {
         spinlock_lock lk{ splk_ };
-		return is_empty_();
+		return capacity_;
+	}
+
+	std::size_t size() const noexcept {
+		return count_.load( std::memory_order_relaxed);
 	}
 
-	void push( context * c) {
+    // returns the number of contexts queued after the push
+	std::size_t push( context * c) {
         spinlock_lock lk{ splk_ };
 		if ( is_full_() ) {
 			resize_();
 		}
 		slots_[pidx_] = c;
 		pidx_ = (pidx_ + 1) % capacity_;
+		update_count_();
+		return count_.load( std::memory_order_relaxed);
 	}
 
 	context * pop() {
+		if ( empty() ) {
+			return nullptr;
+		}
         spinlock_lock lk{ splk_ };
 		context * c = nullptr;
 		if ( ! is_empty_() ) {
 			c = slots_[cidx_];
 			cidx_ = (cidx_ + 1) % capacity_;
+			update_count_();
 		}
 		return c;
 	}
 
 	context * steal() {
+		if ( empty() ) {
+			// idle schedulers probing an empty queue (e.g. the overflow
+			// queue of a stealing domain) do not contend for the lock
+			return nullptr;
+		}
         spinlock_lock lk{ splk_ };
 		context * c = nullptr;
 		if ( ! is_empty_() ) {
 			c = slots_[cidx_];
-            if ( c->is_context( type::pinned_context) ) {
-                return nullptr;
-            }
+            // pinned contexts are never pushed
+            BOOST_ASSERT( ! c->is_context( type::pinned_context) );
 			cidx_ = (cidx_ + 1) % capacity_;
+			update_count_();
 		}
 		return c;
 	}
+
+    // called by the owner while the scheduler is idle: grown slots are
+    // replaced by the initial capacity if the contexts fit into it
+    void shrink() {
+        spinlock_lock lk{ splk_ };
+        const std::size_t size = ( pidx_ + capacity_ - cidx_) % capacity_;
+        if ( min_capacity_ < capacity_ && size < min_capacity_ / 2) {
+            slot_type * old_slots = slots_;
+            slots_ = new slot_type[min_capacity_];
+            for ( std::size_t i = 0; i < size; ++i) {
+                slots_[i] = old_slots[(cidx_ + i) % capacity_];
+            }
+            cidx_ = 0;
+            pidx_ = size;
+            capacity_ = min_capacity_;
+            delete [] old_slots;
+        }
+    }
+
+    // steals up to half of the contexts (at most max_steal_batch);
+    // the first context is returned, the others are pushed to dst
+    context * steal_half( context_spinlock_queue & dst) {
+        if ( empty() ) {
+            return nullptr;
+        }
+        context * batch[max_steal_batch];
+        std::size_t count = 0;
+        {
+            spinlock_lock lk{ splk_ };
+            count = ( ( pidx_ + capacity_ - cidx_) % capacity_ + 1) / 2;
+            if ( max_steal_batch < count) {
+                count = max_steal_batch;
+            }
+            for ( std::size_t i = 0; i < count; ++i) {
+                batch[i] = slots_[cidx_];
+                // pinned contexts are never pushed
+                BOOST_ASSERT( ! batch[i]->is_context( type::pinned_context) );
+                cidx_ = (cidx_ + 1) % capacity_;
+            }
+            update_count_();
+        }
+        if ( 0 == count) {
+            return nullptr;
+        }
+        // dst is locked after the victim has been released
+        for ( std::size_t i = 1; i < count; ++i) {
+            dst.push( batch[i]);
+        }
+        return batch[0];
+    }
 };
 
 }}}
@@ -13,6 +13,7 @@
 #include <memory>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <boost/assert.hpp>
 #include <boost/config.hpp>
@@ -29,6 +30,21 @@
 // Correct and efficient work-stealing for weak memory models.
 // In Proceedings of the 18th ACM SIGPLAN symposium on Principles and practice
 // of parallel programming (PPoPP '13). ACM, New York, NY, USA, 69-80.
+//
+// steal_half() claims a range of contexts with one CAS on top_ (as the
+// run-queues of the Go runtime); as long as the owner's pop() finds
+// fewer than max_steal_batch contexts, it claims the context at the top
+// via CAS too, thus a range stolen concurrently never contains the
+// context taken from the bottom
+//
+// retired arrays (after growing or shrinking) are freed by the owner
+// after a grace period: thieves register in the counter of the current
+// phase; the owner flips the phase and frees the arrays retired before
+// the flip as soon as the counter of the previous phase drops to zero
+// (thieves entering later register in the new phase and load the current
+// array), thus sustained stealing does not delay the reclamation; at most
+// the arrays retired during two phases are retained
+// a thief probing an empty queue does not register
 
 #if BOOST_COMP_CLANG
 #pragma clang diagnostic push
@@ -40,6 +56,10 @@ namespace fibers {
 namespace detail {
 
 class context_spmc_queue {
+public:
+    // max. number of contexts moved by steal_half()
+    static constexpr std::size_t max_steal_batch = 32;
+
 private:
     class array {
     private:
@@ -81,8 +101,8 @@ private:
                     ->load( std::memory_order_relaxed);
         }
 
-        array * resize( std::size_t bottom, std::size_t top) {
-            std::unique_ptr< array > tmp{ new array{ 2 * capacity_ } };
+        array * resize( std::size_t bottom, std::size_t top, std::size_t capacity) {
+            std::unique_ptr< array > tmp{ new array{ capacity } };
             for ( std::size_t i = top; i != bottom; ++i) {
                 tmp->push( i, pop( i) );
             }
@@ -90,22 +110,100 @@ private:
         }
     };
 
+    // indices grow monotonically, pop() decrements bottom_ temporarily
+    // (below top_, even below zero), thus compare the signed distance
+    static std::ptrdiff_t distance_( std::size_t top, std::size_t bottom) noexcept {
+        return static_cast< std::ptrdiff_t >( bottom - top);
+    }
+
+    // counts the thieves accessing an array in the current phase
+    class stealer_guard {
+    private:
+        std::atomic< std::size_t >  *   stealers_;
+
+    public:
+        stealer_guard( std::atomic< std::size_t > * stealers,
+                       std::atomic< std::size_t > const& phase) noexcept {
+            std::size_t p = phase.load( std::memory_order_relaxed);
+            for (;;) {
+                stealers[p].fetch_add( 1, std::memory_order_seq_cst);
+                // pairs with the flip in reclaim_(): either the owner sees
+                // the thief or the thief sees the new phase
+                const std::size_t current = phase.load( std::memory_order_seq_cst);
+                if ( current == p) {
+                    break;
+                }
+                stealers[p].fetch_sub( 1, std::memory_order_release);
+                p = current;
+            }
+            stealers_ = stealers + p;
+        }
+
+        ~stealer_guard() {
+            stealers_->fetch_sub( 1, std::memory_order_release);
+        }
+
+        stealer_guard( stealer_guard const&) = delete;
+        stealer_guard & operator=( stealer_guard const&) = delete;
+    };
+
     std::atomic< std::size_t >     top_{ 0 };
     std::atomic< std::size_t >     bottom_{ 0 };
+    std::atomic< std::size_t >     stealers_[2]{ { 0 }, { 0 } };
+    // written only by the owner
+    std::atomic< std::size_t >     phase_{ 0 };
     std::atomic< array * >         array_;
-    std::vector< array * >                                  old_arrays_{};
+    const std::size_t                                       min_capacity_;
+    // retired in the current phase
+    std::vector< array * >                                  retired_{};
+    // retired in the previous phase, freed if its thieves have left
+    std::vector< array * >                                  draining_{};
     char                                                    padding_[cacheline_length];
 
+    static void free_( std::vector< array * > & arrays) noexcept {
+        for ( array * a : arrays) {
+            delete a;
+        }
+        arrays.clear();
+    }
+
+    void retire_( array * old, array * a) {
+        retired_.push_back( old);
+        array_.store( a, std::memory_order_release);
+        reclaim_();
+    }
+
+    void reclaim_() noexcept {
+        const std::size_t p = phase_.load( std::memory_order_relaxed);
+        if ( ! draining_.empty() ) {
+            if ( 0 != stealers_[1 - p].load( std::memory_order_seq_cst) ) {
+                // thieves of the previous phase are still inside
+                return;
+            }
+            free_( draining_);
+        }
+        if ( retired_.empty() ) {
+            return;
+        }
+        draining_.swap( retired_);
+        // thieves registering from now on load the current array
+        phase_.store( 1 - p, std::memory_order_seq_cst);
+        if ( 0 == stealers_[p].load( std::memory_order_seq_cst) ) {
+            free_( draining_);
+        }
+    }
+
 public:
     context_spmc_queue( std::size_t capacity = 4096) :
-        array_{ new array{ capacity } } {
-        old_arrays_.reserve( 32);
+        array_{ new array{ capacity } },
+        min_capacity_{ capacity } {
+        retired_.reserve( 32);
+        draining_.reserve( 32);
     }
 
     ~context_spmc_queue() {
-        for ( array * a : old_arrays_) {
-            delete a;
-        }
+        free_( retired_);
+        free_( draining_);
         delete array_.load();
     }
 
@@ -115,68 +213,102 @@ public:
     bool empty() const noexcept {
         std::size_t bottom = bottom_.load( std::memory_order_relaxed);
         std::size_t top = top_.load( std::memory_order_relaxed);
-        return bottom <= top;
+        return 0 >= distance_( top, bottom);
+    }
+
+    std::size_t capacity() const noexcept {
+        return array_.load( std::memory_order_relaxed)->capacity();
     }
 
-    void push( context * ctx) {
+    // approximation if called concurrently to steal()
+    std::size_t size() const noexcept {
+        std::size_t bottom = bottom_.load( std::memory_order_relaxed);
+        std::size_t top = top_.load( std::memory_order_relaxed);
+        const std::ptrdiff_t distance = distance_( top, bottom);
+        return 0 < distance ? static_cast< std::size_t >( distance) : 0;
+    }
+
+    // returns the number of contexts queued after the push
+    // (approximation if called concurrently to steal())
+    std::size_t push( context * ctx) {
         std::size_t bottom = bottom_.load( std::memory_order_relaxed);
         std::size_t top = top_.load( std::memory_order_acquire);
         array * a = array_.load( std::memory_order_relaxed);
         if ( (a->capacity() - 1) < (bottom - top) ) {
             // queue is full
             // resize
-            array * tmp = a->resize( bottom, top);
-            old_arrays_.push_back( a);
-            std::swap( a, tmp);
-            array_.store( a, std::memory_order_relaxed);
+            array * tmp = a->resize( bottom, top, 2 * a->capacity() );
+            retire_( a, tmp);
+            a = tmp;
         }
         a->push( bottom, ctx);
         std::atomic_thread_fence( std::memory_order_release);
         bottom_.store( bottom + 1, std::memory_order_relaxed);
+        return bottom + 1 - top;
     }
 
     context * pop() {
+        if ( BOOST_UNLIKELY( ! draining_.empty() || ! retired_.empty() ) ) {
+            reclaim_();
+        }
         std::size_t bottom = bottom_.load( std::memory_order_relaxed) - 1;
         array * a = array_.load( std::memory_order_relaxed);
         bottom_.store( bottom, std::memory_order_relaxed);
         std::atomic_thread_fence( std::memory_order_seq_cst);
         std::size_t top = top_.load( std::memory_order_relaxed);
-        context * ctx = nullptr;
-        if ( top <= bottom) {
-            // queue is not empty
-            ctx = a->pop( bottom);
+        if ( static_cast< std::ptrdiff_t >( max_steal_batch) <= distance_( top, bottom) ) {
+            // no thief can claim the context at the bottom
+            context * ctx = a->pop( bottom);
             BOOST_ASSERT( nullptr != ctx);
-            if ( top == bottom) {
-                // last element dequeued
-                if ( ! top_.compare_exchange_strong( top, top + 1,
-                                                     std::memory_order_seq_cst,
-                                                     std::memory_order_relaxed) ) {
-                    // lose the race
-                    ctx = nullptr;
-                }
-                bottom_.store( bottom + 1, std::memory_order_relaxed);
+            return ctx;
+        }
+        // few contexts left (or queue is empty)
+        // compete with the thieves at the top
+        bottom_.store( bottom + 1, std::memory_order_relaxed);
+        while ( 0 <= distance_( top, bottom) ) {
+            context * ctx = a->pop( top);
+            if ( top_.compare_exchange_weak( top, top + 1,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed) ) {
+                BOOST_ASSERT( nullptr != ctx);
+                return ctx;
             }
-        } else {
-            // queue is empty
-            bottom_.store( bottom + 1, std::memory_order_relaxed);
         }
-        return ctx;
+        return nullptr;
+    }
+
+    // called by the owner while the scheduler is idle: a grown array is
+    // replaced by one of the initial capacity if the contexts fit into it
+    void shrink() {
+        array * a = array_.load( std::memory_order_relaxed);
+        if ( min_capacity_ < a->capacity() ) {
+            std::size_t bottom = bottom_.load( std::memory_order_relaxed);
+            std::size_t top = top_.load( std::memory_order_acquire);
+            if ( distance_( top, bottom) < static_cast< std::ptrdiff_t >( min_capacity_ / 2) ) {
+                retire_( a, a->resize( bottom, top, min_capacity_) );
+            }
+        }
+        reclaim_();
     }
 
     context * steal() {
+        if ( empty() ) {
+            // the probe does not access the array
+            return nullptr;
+        }
+        stealer_guard guard{ stealers_, phase_ };
         std::size_t top = top_.load( std::memory_order_acquire);
         std::atomic_thread_fence( std::memory_order_seq_cst);
         std::size_t bottom = bottom_.load( std::memory_order_acquire);
         context * ctx = nullptr;
-        if ( top < bottom) {
+        if ( 0 < distance_( top, bottom) ) {
             // queue is not empty
             array * a = array_.load( std::memory_order_consume);
             ctx = a->pop( top);
             BOOST_ASSERT( nullptr != ctx);
-            // do not steal pinned context (e.g. main-/dispatcher-context)
-            if ( ctx->is_context( type::pinned_context) ) {
-                return nullptr;
-            }
+            // pinned contexts (main-/dispatcher-context) are
+            // never pushed, the algorithms keep them locally
+            BOOST_ASSERT( ! ctx->is_context( type::pinned_context) );
             if ( ! top_.compare_exchange_strong( top, top + 1,
                                                  std::memory_order_seq_cst,
                                                  std::memory_order_relaxed) ) {
@@ -186,6 +318,46 @@ public:
         }
         return ctx;
     }
+
+    // steals up to half of the contexts (at most max_steal_batch) with
+    // one CAS; the first context is returned, the others are pushed
+    // to dst, which must be owned by the calling thread
+    context * steal_half( context_spmc_queue & dst) {
+        if ( empty() ) {
+            // the probe does not access the array
+            return nullptr;
+        }
+        stealer_guard guard{ stealers_, phase_ };
+        std::size_t top = top_.load( std::memory_order_acquire);
+        std::atomic_thread_fence( std::memory_order_seq_cst);
+        std::size_t bottom = bottom_.load( std::memory_order_acquire);
+        const std::ptrdiff_t distance = distance_( top, bottom);
+        if ( 0 >= distance) {
+            // queue is empty
+            return nullptr;
+        }
+        std::size_t count = ( static_cast< std::size_t >( distance) + 1) / 2;
+        if ( max_steal_batch < count) {
+            count = max_steal_batch;
+        }
+        context * batch[max_steal_batch];
+        array * a = array_.load( std::memory_order_consume);
+        for ( std::size_t i = 0; i < count; ++i) {
+            batch[i] = a->pop( top + i);
+            BOOST_ASSERT( nullptr != batch[i]);
+            BOOST_ASSERT( ! batch[i]->is_context( type::pinned_context) );
+        }
+        if ( ! top_.compare_exchange_strong( top, top + count,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed) ) {
+            // lose the race
+            return nullptr;
+        }
+        for ( std::size_t i = 1; i < count; ++i) {
+            dst.push( batch[i]);
+        }
+        return batch[0];
+    }
 };
 
 }}}
@@ -15,6 +15,8 @@
 #include <boost/config.hpp>
 #include <boost/intrusive_ptr.hpp>
 
+#include <boost/fiber/detail/config.hpp>
+
 #ifdef BOOST_HAS_ABI_HEADERS
 #  include BOOST_ABI_PREFIX
 #endif
@@ -50,6 +52,21 @@ public:
     }
 };
 
+// dense index of a fiber_specific_ptr into the fiber-specific values of a
+// context; indices of destroyed fiber_specific_ptrs are reused, the generation
+// distinguishes values of a destroyed fiber_specific_ptr from the values of
+// the fiber_specific_ptr reusing its index
+struct fss_key {
+    std::size_t     index;
+    std::size_t     generation;
+};
+
+BOOST_FIBERS_DECL
+fss_key allocate_fss_key();
+
+BOOST_FIBERS_DECL
+void deallocate_fss_key( fss_key const&) noexcept;
+
 }}}
 
 #ifdef BOOST_HAS_ABI_HEADERS
@@ -7,6 +7,10 @@
 #ifndef BOOST_FIBERS_DETAIL_FUTEX_H
 #define BOOST_FIBERS_DETAIL_FUTEX_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
 #include <boost/config.hpp>
 #include <boost/predef.h> 
 
@@ -16,6 +20,8 @@
 extern "C" {
 #include <linux/futex.h>
 #include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
 }
 #elif BOOST_OS_WINDOWS
 #include <Windows.h>
@@ -31,6 +37,11 @@ int sys_futex( void * addr, std::int32_t op, std::int32_t x) {
     return ::syscall( SYS_futex, addr, op, x, nullptr, nullptr, 0);
 }
 
+BOOST_FORCEINLINE
+int sys_futex( void * addr, std::int32_t op, std::int32_t x, ::timespec const* timeout) {
+    return ::syscall( SYS_futex, addr, op, x, timeout, nullptr, 0);
+}
+
 BOOST_FORCEINLINE
 int futex_wake( std::atomic< std::int32_t > * addr) {
     return 0 <= sys_futex( static_cast< void * >( addr), FUTEX_WAKE_PRIVATE, 1) ? 0 : -1;
@@ -40,6 +51,16 @@ BOOST_FORCEINLINE
 int futex_wait( std::atomic< std::int32_t > * addr, std::int32_t x) {
     return 0 <= sys_futex( static_cast< void * >( addr), FUTEX_WAIT_PRIVATE, x) ? 0 : -1;
 }
+
+// relative timeout, measured against CLOCK_MONOTONIC
+BOOST_FORCEINLINE
+int futex_wait( std::atomic< std::int32_t > * addr, std::int32_t x, std::chrono::nanoseconds const& timeout) {
+    const std::chrono::seconds sec = std::chrono::duration_cast< std::chrono::seconds >( timeout);
+    ::timespec ts;
+    ts.tv_sec = static_cast< decltype( ts.tv_sec) >( sec.count() );
+    ts.tv_nsec = static_cast< decltype( ts.tv_nsec) >( ( timeout - sec).count() );
+    return 0 <= sys_futex( static_cast< void * >( addr), FUTEX_WAIT_PRIVATE, x, & ts) ? 0 : -1;
+}
 #elif BOOST_OS_WINDOWS
 BOOST_FORCEINLINE
 int futex_wake( std::atomic< std::int32_t > * addr) {
@@ -52,6 +73,14 @@ int futex_wait( std::atomic< std::int32_t > * addr, std::int32_t x) {
     ::WaitOnAddress( static_cast< volatile void * >( addr), & x, sizeof( x), INFINITE);
     return 0;
 }
+
+BOOST_FORCEINLINE
+int futex_wait( std::atomic< std::int32_t > * addr, std::int32_t x, std::chrono::nanoseconds const& timeout) {
+    // round up, WaitOnAddress() accepts milliseconds (INFINITE excluded)
+    const std::int64_t ms = ( timeout.count() + 999999) / 1000000;
+    const DWORD dw = static_cast< DWORD >( ms < INFINITE ? ms : INFINITE - 1);
+    return ::WaitOnAddress( static_cast< volatile void * >( addr), & x, sizeof( x), dw) ? 0 : -1;
+}
 #else
 # warn "no futex support on this platform"
 #endif
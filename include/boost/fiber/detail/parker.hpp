@@ -0,0 +1,132 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_DETAIL_PARKER_H
+#define BOOST_FIBERS_DETAIL_PARKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+#if defined(BOOST_FIBERS_HAS_FUTEX)
+# include <boost/fiber/detail/futex.hpp>
+#else
+# include <condition_variable>
+# include <mutex>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+// parks the thread owning a scheduling algorithm
+// (algorithm::suspend_until()) till a deadline is reached
+// or another thread calls unpark() (algorithm::notify())
+// an unpark() without a parked thread is not lost, the next
+// call of park_until() returns immediately
+// only one thread might call park_until(), any thread unpark()
+#if defined(BOOST_FIBERS_HAS_FUTEX)
+class parker {
+private:
+    enum {
+        parked = -1,
+        empty = 0,
+        notified = 1
+    };
+
+    std::atomic< std::int32_t >     state_{ empty };
+
+public:
+    parker() = default;
+
+    parker( parker const&) = delete;
+    parker & operator=( parker const&) = delete;
+
+    void park_until( std::chrono::steady_clock::time_point const& time_point) noexcept {
+        std::int32_t expected = notified;
+        // consume a pending notification
+        if ( state_.compare_exchange_strong( expected, empty, std::memory_order_acquire) ) {
+            return;
+        }
+        BOOST_ASSERT( empty == expected);
+        if ( ! state_.compare_exchange_strong( expected, parked, std::memory_order_acquire) ) {
+            // notified in between
+            state_.store( empty, std::memory_order_relaxed);
+            return;
+        }
+        for (;;) {
+            if ( (std::chrono::steady_clock::time_point::max)() == time_point) {
+                futex_wait( & state_, parked);
+            } else {
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if ( time_point <= now) {
+                    break;
+                }
+                futex_wait( & state_, parked,
+                            std::chrono::duration_cast< std::chrono::nanoseconds >( time_point - now) );
+            }
+            // futex_wait() might return spuriously
+            if ( notified == state_.load( std::memory_order_acquire) ) {
+                break;
+            }
+        }
+        // consume notification or leave parked state (timeout)
+        state_.exchange( empty, std::memory_order_acquire);
+    }
+
+    void unpark() noexcept {
+        // syscall only if the owning thread is blocked
+        if ( parked == state_.exchange( notified, std::memory_order_release) ) {
+            futex_wake( & state_);
+        }
+    }
+};
+#else
+class parker {
+private:
+    std::mutex                  mtx_{};
+    std::condition_variable     cnd_{};
+    bool                        flag_{ false };
+
+public:
+    parker() = default;
+
+    parker( parker const&) = delete;
+    parker & operator=( parker const&) = delete;
+
+    void park_until( std::chrono::steady_clock::time_point const& time_point) noexcept {
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        if ( (std::chrono::steady_clock::time_point::max)() == time_point) {
+            cnd_.wait( lk, [this](){ return flag_; });
+        } else {
+            cnd_.wait_until( lk, time_point, [this](){ return flag_; });
+        }
+        flag_ = false;
+    }
+
+    void unpark() noexcept {
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        flag_ = true;
+        lk.unlock();
+        cnd_.notify_all();
+    }
+};
+#endif
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_DETAIL_PARKER_H
@@ -0,0 +1,329 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_DETAIL_STACK_CACHE_H
+#define BOOST_FIBERS_DETAIL_STACK_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/context/fixedsize_stack.hpp>
+#include <boost/context/pooled_fixedsize_stack.hpp>
+#include <boost/context/protected_fixedsize_stack.hpp>
+#include <boost/context/stack_context.hpp>
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+# include <boost/context/segmented_stack.hpp>
+#endif
+
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+// a cached stack is handed out only for an allocator equal to the
+// allocator that has allocated it (same stack size, same pool, ...);
+// allocators are compared with operator==, stacks of allocators
+// without equality are not cached
+template< typename StackAlloc, typename = void >
+struct stack_allocator_equal : public std::false_type {
+    static bool equal( StackAlloc const&, StackAlloc const&) noexcept {
+        return false;
+    }
+};
+
+template< typename StackAlloc >
+struct stack_allocator_equal<
+    StackAlloc,
+    decltype( void( std::declval< StackAlloc const& >() == std::declval< StackAlloc const& >() ) )
+> : public std::true_type {
+    static bool equal( StackAlloc const& l, StackAlloc const& r) noexcept {
+        return l == r;
+    }
+};
+
+// the allocators of Boost.Context have no operator==, their state is
+// a single member (stack size or pointer to the pool) without padding
+template< typename StackAlloc >
+struct stack_allocator_single_member : public std::true_type {
+    static bool equal( StackAlloc const& l, StackAlloc const& r) noexcept {
+        static_assert( sizeof( StackAlloc) == sizeof( std::size_t) || sizeof( StackAlloc) == sizeof( void *),
+                       "stack allocator has more than one member");
+        return 0 == std::memcmp( static_cast< void const* >( & l),
+                                 static_cast< void const* >( & r),
+                                 sizeof( StackAlloc) );
+    }
+};
+
+template< typename traitsT >
+struct stack_allocator_equal< boost::context::basic_fixedsize_stack< traitsT > > :
+    public stack_allocator_single_member< boost::context::basic_fixedsize_stack< traitsT > > {
+};
+
+template< typename traitsT >
+struct stack_allocator_equal< boost::context::basic_protected_fixedsize_stack< traitsT > > :
+    public stack_allocator_single_member< boost::context::basic_protected_fixedsize_stack< traitsT > > {
+};
+
+template< typename traitsT >
+struct stack_allocator_equal< boost::context::basic_pooled_fixedsize_stack< traitsT > > :
+    public stack_allocator_single_member< boost::context::basic_pooled_fixedsize_stack< traitsT > > {
+};
+
+// stacks of these allocators are never cached
+template< typename StackAlloc >
+struct is_stack_cacheable : public std::integral_constant< bool, stack_allocator_equal< StackAlloc >::value > {
+};
+
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+template<>
+struct is_stack_cacheable< boost::context::segmented_stack > : public std::false_type {
+};
+#endif
+
+// cache of stacks of terminated fibers, owned by a scheduler
+// and accessed only by the thread running the scheduler
+// a cached stack is keyed by the type of its stack allocator and its size;
+// the stack is handed out only for an equal allocator
+// (stack_allocator_equal), e.g. the same pool or the same stack size
+// a copy of the allocator is stored inside the unused stack memory
+// and is used to deallocate the stack if it is evicted
+class stack_cache {
+private:
+    template< typename StackAlloc >
+    struct tag {
+        static const char   id;
+    };
+
+    struct node {
+        node                            *   next{ nullptr };
+        boost::context::stack_context       sctx;
+        void                             (* destroy)( node *);
+
+        node( boost::context::stack_context const& sctx_,
+              void (* destroy_)( node *) ) noexcept :
+            sctx( sctx_),
+            destroy{ destroy_ } {
+        }
+    };
+
+    template< typename StackAlloc >
+    struct node_impl : public node {
+        StackAlloc      salloc;
+
+        node_impl( StackAlloc && salloc_, boost::context::stack_context const& sctx_) noexcept :
+            node{ sctx_, & node_impl::destroy_ },
+            salloc( std::move( salloc_) ) {
+        }
+
+        // evict: deallocate the stack via the stored allocator
+        static void destroy_( node * n) {
+            node_impl * impl = static_cast< node_impl * >( n);
+            StackAlloc salloc = std::move( impl->salloc);
+            boost::context::stack_context sctx = impl->sctx;
+            impl->~node_impl();
+            salloc.deallocate( sctx);
+        }
+    };
+
+    struct bucket {
+        void const      *   type;
+        std::size_t         size;
+        node            *   head;
+        std::size_t         count;
+    };
+
+    std::vector< bucket >       buckets_{};
+    std::size_t                 count_{ 0 };
+    std::size_t                 bytes_{ 0 };
+    std::size_t                 max_count_{ BOOST_FIBERS_STACK_CACHE_MAX_COUNT };
+    std::size_t                 max_bytes_{ BOOST_FIBERS_STACK_CACHE_MAX_BYTES };
+
+    template< typename StackAlloc >
+    static node_impl< StackAlloc > * to_impl_( node * n) noexcept {
+        return static_cast< node_impl< StackAlloc > * >( n);
+    }
+
+    void evict_( std::vector< bucket >::iterator i) noexcept {
+        node * n = i->head;
+        i->head = n->next;
+        --i->count;
+        --count_;
+        bytes_ -= n->sctx.size;
+        if ( nullptr == i->head) {
+            buckets_.erase( i);
+        }
+        n->destroy( n);
+    }
+
+public:
+    stack_cache() = default;
+
+    stack_cache( stack_cache const&) = delete;
+    stack_cache & operator=( stack_cache const&) = delete;
+
+    ~stack_cache() {
+        trim();
+    }
+
+    // take a cached stack suitable for salloc
+    template< typename StackAlloc >
+    bool pop( StackAlloc const& salloc, boost::context::stack_context & sctx) noexcept {
+        if ( ! is_stack_cacheable< StackAlloc >::value) {
+            return false;
+        }
+        for ( std::vector< bucket >::iterator i = buckets_.begin(); i != buckets_.end(); ++i) {
+            if ( & tag< StackAlloc >::id == i->type &&
+                 stack_allocator_equal< StackAlloc >::equal( to_impl_< StackAlloc >( i->head)->salloc, salloc) ) {
+                node_impl< StackAlloc > * impl = to_impl_< StackAlloc >( i->head);
+                i->head = impl->next;
+                --i->count;
+                --count_;
+                bytes_ -= impl->sctx.size;
+                if ( nullptr == i->head) {
+                    buckets_.erase( i);
+                }
+                sctx = impl->sctx;
+                // the stored allocator is equivalent to salloc
+                impl->~node_impl();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // cache the stack of a terminated fiber; returns false
+    // if the limits are reached, the caller has to deallocate
+    // the stack then
+    template< typename StackAlloc >
+    bool push( StackAlloc & salloc, boost::context::stack_context const& sctx) noexcept {
+        typedef node_impl< StackAlloc >   impl_t;
+        if ( ! is_stack_cacheable< StackAlloc >::value ||
+             count_ >= max_count_ ||
+             bytes_ + sctx.size > max_bytes_ ||
+             sctx.size < sizeof( impl_t) + alignof( impl_t) ) {
+            return false;
+        }
+        // place node on top of the unused stack
+        void * storage = reinterpret_cast< void * >(
+                ( reinterpret_cast< uintptr_t >( sctx.sp) - static_cast< uintptr_t >( sizeof( impl_t) ) )
+                & ~ static_cast< uintptr_t >( alignof( impl_t) - 1) );
+        impl_t * impl = new ( storage) impl_t{ std::move( salloc), sctx };
+        std::vector< bucket >::iterator i = buckets_.begin();
+        for (; i != buckets_.end(); ++i) {
+            if ( & tag< StackAlloc >::id == i->type &&
+                 sctx.size == i->size &&
+                 stack_allocator_equal< StackAlloc >::equal( to_impl_< StackAlloc >( i->head)->salloc, impl->salloc) ) {
+                break;
+            }
+        }
+        if ( buckets_.end() == i) {
+            bucket b{ & tag< StackAlloc >::id, sctx.size, nullptr, 0 };
+            try {
+                buckets_.push_back( b);
+            } catch (...) {
+                // restore allocator, caller deallocates the stack
+                salloc = std::move( impl->salloc);
+                impl->~impl_t();
+                return false;
+            }
+            i = buckets_.end() - 1;
+        }
+        // LIFO, the most recently used stack is hot in the cache
+        impl->next = i->head;
+        i->head = impl;
+        ++i->count;
+        ++count_;
+        bytes_ += sctx.size;
+        return true;
+    }
+
+    // deallocate cached stacks till at most max_bytes are cached
+    void trim( std::size_t max_bytes = 0) noexcept {
+        while ( bytes_ > max_bytes && ! buckets_.empty() ) {
+            // evict from the bucket holding most stacks
+            std::vector< bucket >::iterator victim = buckets_.begin();
+            for ( std::vector< bucket >::iterator i = buckets_.begin(); i != buckets_.end(); ++i) {
+                if ( i->count > victim->count) {
+                    victim = i;
+                }
+            }
+            evict_( victim);
+        }
+    }
+
+    void set_limits( std::size_t max_count, std::size_t max_bytes) noexcept {
+        max_count_ = max_count;
+        max_bytes_ = max_bytes;
+        while ( count_ > max_count_) {
+            evict_( buckets_.begin() );
+        }
+        trim( max_bytes_);
+    }
+
+    std::size_t size() const noexcept {
+        return count_;
+    }
+
+    std::size_t bytes() const noexcept {
+        return bytes_;
+    }
+};
+
+template< typename StackAlloc >
+const char stack_cache::tag< StackAlloc >::id = 0;
+
+// stack-cache of the scheduler running in the current thread,
+// nullptr if the thread has no (or a terminating) scheduler
+BOOST_FIBERS_DECL
+stack_cache * current_stack_cache() noexcept;
+
+// stack allocator used for worker-contexts, allocates from
+// and deallocates into the stack-cache of the current thread
+template< typename StackAlloc >
+class cached_stack_allocator {
+private:
+    StackAlloc      salloc_;
+
+public:
+    explicit cached_stack_allocator( StackAlloc const& salloc) :
+        salloc_( salloc) {
+    }
+
+    boost::context::stack_context allocate() {
+        boost::context::stack_context sctx;
+        stack_cache * cache = current_stack_cache();
+        if ( nullptr == cache || ! cache->pop( salloc_, sctx) ) {
+            sctx = salloc_.allocate();
+        }
+        return sctx;
+    }
+
+    void deallocate( boost::context::stack_context & sctx) noexcept {
+        stack_cache * cache = current_stack_cache();
+        if ( nullptr == cache || ! cache->push( salloc_, sctx) ) {
+            salloc_.deallocate( sctx);
+        }
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_DETAIL_STACK_CACHE_H
@@ -0,0 +1,296 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_DETAIL_TIMER_WHEEL_H
+#define BOOST_FIBERS_DETAIL_TIMER_WHEEL_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/intrusive/list.hpp>
+
+#include <boost/fiber/context.hpp>
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+// George Varghese and Tony Lauck. 1987.
+// Hashed and hierarchical timing wheels: data structures for the efficient
+// implementation of a timer facility.
+// In Proceedings of the eleventh ACM Symposium on Operating systems
+// principles (SOSP '87). ACM, New York, NY, USA, 25-38.
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+// hierarchical timing wheel used as sleep-queue
+//  - insert: O(1)
+//  - cancel: O(1), via context::sleep_unlink() (auto-unlink hook)
+//  - expire: amortized O(1), a context is cascaded at most once per level
+// time is measured in ticks of BOOST_FIBERS_TIMER_WHEEL_RESOLUTION
+// microseconds; a context is never resumed before its deadline
+class timer_wheel {
+private:
+    typedef intrusive::list<
+                context,
+                intrusive::member_hook<
+                    context, sleep_wheel_hook, & context::sleep_wheel_hook_ >,
+                intrusive::constant_time_size< false >
+            >                                               slot_type;
+
+    static constexpr std::size_t    slot_bits = 6;
+    static constexpr std::size_t    slot_count = std::size_t( 1) << slot_bits;
+    static constexpr std::uint64_t  slot_mask = slot_count - 1;
+    static constexpr std::size_t    level_count = 6;
+
+    struct level {
+        // bit i is set if slot i might contain a context;
+        // a slot becomes empty without clearing its bit
+        // if a context is unlinked (auto-unlink hook)
+        std::uint64_t                           bitmap{ 0 };
+        std::array< slot_type, slot_count >     slots{};
+    };
+
+    std::chrono::steady_clock::time_point       origin_;
+    // all ticks before current_ have been expired
+    std::uint64_t                               current_{ 0 };
+    std::array< level, level_count >            levels_{};
+
+    static std::chrono::steady_clock::duration resolution_() noexcept {
+        return std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                std::chrono::microseconds{ BOOST_FIBERS_TIMER_WHEEL_RESOLUTION } );
+    }
+
+    static std::size_t ctz_( std::uint64_t x) noexcept {
+        BOOST_ASSERT( 0 != x);
+#if BOOST_COMP_GNUC || BOOST_COMP_CLANG
+        return static_cast< std::size_t >( __builtin_ctzll( x) );
+#else
+        std::size_t n = 0;
+        while ( 0 == ( x & 1) ) {
+            x >>= 1;
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    static std::size_t digit_( std::uint64_t tick, std::size_t lvl) noexcept {
+        return static_cast< std::size_t >( ( tick >> ( slot_bits * lvl) ) & slot_mask);
+    }
+
+    std::uint64_t tick_( std::chrono::steady_clock::time_point const& tp) const noexcept {
+        if ( tp <= origin_) {
+            return 0;
+        }
+        return static_cast< std::uint64_t >( ( tp - origin_) / resolution_() );
+    }
+
+    std::chrono::steady_clock::time_point time_point_( std::uint64_t tick) const noexcept {
+        return origin_ + resolution_() * tick;
+    }
+
+    void link_( context * ctx) noexcept {
+        const std::uint64_t tick = (std::max)( tick_( ctx->tp_), current_);
+        // lowest level at which tick and current_ share all higher digits
+        std::size_t lvl = 0;
+        while ( lvl < level_count - 1 &&
+                ( tick >> ( slot_bits * ( lvl + 1) ) ) != ( current_ >> ( slot_bits * ( lvl + 1) ) ) ) {
+            ++lvl;
+        }
+        std::size_t idx = digit_( tick, lvl);
+        if ( ( tick >> ( slot_bits * level_count) ) != ( current_ >> ( slot_bits * level_count) ) ) {
+            // beyond the horizon of the wheel: park the context in the slot
+            // of the top level that is cascaded last, it is re-linked then
+            idx = ( digit_( current_, lvl) + slot_mask) & slot_mask;
+        }
+        levels_[lvl].slots[idx].push_back( * ctx);
+        levels_[lvl].bitmap |= std::uint64_t( 1) << idx;
+    }
+
+    // re-link the context' of the slot at level `lvl`
+    // that has become current
+    void cascade_( std::size_t lvl) noexcept {
+        const std::size_t idx = digit_( current_, lvl);
+        slot_type tmp;
+        tmp.splice( tmp.end(), levels_[lvl].slots[idx]);
+        levels_[lvl].bitmap &= ~ ( std::uint64_t( 1) << idx);
+        while ( ! tmp.empty() ) {
+            context * ctx = & tmp.front();
+            tmp.pop_front();
+            link_( ctx);
+        }
+    }
+
+    // advance current_ to `tick`
+    void step_( std::uint64_t tick) noexcept {
+        BOOST_ASSERT( tick > current_);
+        const std::uint64_t prev = current_;
+        current_ = tick;
+        // cascade from top to bottom, context' of a higher level might
+        // be moved into a slot of a lower level that is current too
+        for ( std::size_t lvl = level_count - 1; 0 < lvl; --lvl) {
+            if ( ( prev >> ( slot_bits * lvl) ) != ( current_ >> ( slot_bits * lvl) ) &&
+                 0 != levels_[lvl].bitmap) {
+                cascade_( lvl);
+            }
+        }
+    }
+
+    // next tick after current_ at which a slot of level 0 expires
+    // or a slot of a higher level has to be cascaded
+    std::uint64_t next_tick_() const noexcept {
+        std::uint64_t next = (std::numeric_limits< std::uint64_t >::max)();
+        // level 0 holds only ticks of the block of current_,
+        // mask out the slots up to and including current_
+        const std::uint64_t pending = levels_[0].bitmap &
+            ~ ( ( std::uint64_t( 2) << digit_( current_, 0) ) - 1);
+        if ( 0 != pending) {
+            next = ( current_ & ~ slot_mask) + ctz_( pending);
+        }
+        for ( std::size_t lvl = 1; lvl < level_count; ++lvl) {
+            const std::uint64_t bitmap = levels_[lvl].bitmap;
+            if ( 0 != bitmap) {
+                // distance to the next slot after the current one,
+                // rotate the bitmap so that this slot becomes bit 0
+                const std::size_t from = ( digit_( current_, lvl) + 1) & slot_mask;
+                const std::uint64_t rotated = 0 == from
+                    ? bitmap
+                    : ( bitmap >> from) | ( bitmap << ( slot_count - from) );
+                const std::uint64_t d = ctz_( rotated) + 1;
+                next = (std::min)( next, ( ( current_ >> ( slot_bits * lvl) ) + d) << ( slot_bits * lvl) );
+            }
+        }
+        return next;
+    }
+
+public:
+    timer_wheel() noexcept :
+        origin_{ std::chrono::steady_clock::now() } {
+    }
+
+    timer_wheel( timer_wheel const&) = delete;
+    timer_wheel & operator=( timer_wheel const&) = delete;
+
+    ~timer_wheel() {
+        BOOST_ASSERT( empty() );
+    }
+
+    bool empty() const noexcept {
+        for ( level const& l : levels_) {
+            for ( std::uint64_t bitmap = l.bitmap; 0 != bitmap; bitmap &= bitmap - 1) {
+                if ( ! l.slots[ctz_( bitmap)].empty() ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void insert( context * ctx) noexcept {
+        BOOST_ASSERT( nullptr != ctx);
+        BOOST_ASSERT( ! ctx->sleep_is_linked() );
+        link_( ctx);
+    }
+
+    // remove an arbitrary context, used to migrate
+    // the context' into another sleep-queue
+    context * pop() noexcept {
+        for ( level & l : levels_) {
+            while ( 0 != l.bitmap) {
+                const std::size_t idx = ctz_( l.bitmap);
+                if ( ! l.slots[idx].empty() ) {
+                    context * ctx = & l.slots[idx].front();
+                    l.slots[idx].pop_front();
+                    return ctx;
+                }
+                l.bitmap &= ~ ( std::uint64_t( 1) << idx);
+            }
+        }
+        return nullptr;
+    }
+
+    // invoke fn for each context with a deadline <= now,
+    // the context has been unlinked before fn is called
+    template< typename Fn >
+    void expire( std::chrono::steady_clock::time_point const& now, Fn && fn) noexcept {
+        const std::uint64_t target = tick_( now);
+        for (;;) {
+            level & l0 = levels_[0];
+            const std::size_t idx = digit_( current_, 0);
+            if ( 0 != ( l0.bitmap & ( std::uint64_t( 1) << idx) ) ) {
+                slot_type & slot = l0.slots[idx];
+                for ( slot_type::iterator i = slot.begin(); i != slot.end();) {
+                    context * ctx = & ( * i);
+                    if ( ctx->tp_ <= now) {
+                        i = slot.erase( i);
+                        fn( ctx);
+                    } else {
+                        // only possible for the tick containing `now`
+                        BOOST_ASSERT( current_ == target);
+                        ++i;
+                    }
+                }
+                if ( slot.empty() ) {
+                    l0.bitmap &= ~ ( std::uint64_t( 1) << idx);
+                }
+            }
+            if ( current_ >= target) {
+                break;
+            }
+            // skip ticks without slots to expire or to cascade
+            step_( (std::min)( next_tick_(), target) );
+        }
+    }
+
+    // earliest deadline if it is stored at level 0,
+    // otherwise the time of the next cascade (lower bound)
+    std::chrono::steady_clock::time_point next_deadline() noexcept {
+        // drop stale bits, otherwise the dispatcher would wake up
+        // for slots that have become empty
+        for ( level & l : levels_) {
+            for ( std::uint64_t bitmap = l.bitmap; 0 != bitmap; bitmap &= bitmap - 1) {
+                const std::size_t idx = ctz_( bitmap);
+                if ( l.slots[idx].empty() ) {
+                    l.bitmap &= ~ ( std::uint64_t( 1) << idx);
+                }
+            }
+        }
+        level const& l0 = levels_[0];
+        // level 0 holds only ticks of the block of current_
+        // (including current_), mask out expired slots
+        const std::uint64_t pending = l0.bitmap &
+            ~ ( ( std::uint64_t( 1) << digit_( current_, 0) ) - 1);
+        if ( 0 != pending) {
+            std::chrono::steady_clock::time_point tp = (std::chrono::steady_clock::time_point::max)();
+            for ( context const& ctx : l0.slots[ctz_( pending)]) {
+                tp = (std::min)( tp, ctx.tp_);
+            }
+            // a cascade happens not before the end of the current block
+            return tp;
+        }
+        const std::uint64_t tick = next_tick_();
+        return (std::numeric_limits< std::uint64_t >::max)() != tick
+            ? time_point_( tick)
+            : (std::chrono::steady_clock::time_point::max)();
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_DETAIL_TIMER_WHEEL_H
@@ -45,24 +45,28 @@ private:
     };
 
     detail::fss_cleanup_function::ptr_t cleanup_fn_;
+    detail::fss_key                     key_;
 
 public:
     typedef T   element_type;
 
     fiber_specific_ptr() :
-        cleanup_fn_{ new default_cleanup_function() } {
+        cleanup_fn_{ new default_cleanup_function() },
+        key_( detail::allocate_fss_key() ) {
     }
 
     explicit fiber_specific_ptr( void(*fn)(T*) ) :
-        cleanup_fn_{ new custom_cleanup_function( fn) } {
+        cleanup_fn_{ new custom_cleanup_function( fn) },
+        key_( detail::allocate_fss_key() ) {
     }
 
     ~fiber_specific_ptr() {
         context * active_ctx = context::active();
         if ( nullptr != active_ctx) {
             active_ctx->set_fss_data(
-                this, cleanup_fn_, nullptr, true);
+                key_, cleanup_fn_, nullptr, true);
         }
+        detail::deallocate_fss_key( key_);
     }
 
     fiber_specific_ptr( fiber_specific_ptr const&) = delete;
@@ -70,7 +74,7 @@ public:
 
     T * get() const noexcept {
         BOOST_ASSERT( context::active() );
-        void * vp = context::active()->get_fss_data( this);
+        void * vp = context::active()->get_fss_data( key_);
         return static_cast< T * >( vp);
     }
 
@@ -85,7 +89,7 @@ public:
     T * release() {
         T * tmp = get();
         context::active()->set_fss_data(
-            this, cleanup_fn_, nullptr, false);
+            key_, cleanup_fn_, nullptr, false);
         return tmp;
     }
 
@@ -93,7 +97,7 @@ public:
         T * c = get();
         if ( BOOST_LIKELY( c != t) ) {
             context::active()->set_fss_data(
-                this, cleanup_fn_, t, true);
+                key_, cleanup_fn_, t, true);
         }
     }
 };
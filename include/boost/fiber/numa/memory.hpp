@@ -0,0 +1,76 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_NUMA_MEMORY_H
+#define BOOST_FIBERS_NUMA_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/config.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace numa {
+
+// node ID of unknown placement
+constexpr std::uint32_t unknown_node = static_cast< std::uint32_t >( -1);
+
+// NUMA node of the logical cpu running the calling thread: the node
+// announced by set_current_node() or, if not set, reported by the
+// operating system (`0` if not supported)
+BOOST_FIBERS_DECL
+std::uint32_t current_node() noexcept;
+
+// announces that the calling thread is pinned to a logical
+// cpu of node_id (called by numa::work_stealing)
+BOOST_FIBERS_DECL
+void set_current_node( std::uint32_t node_id) noexcept;
+
+// node announced by set_current_node() for the calling thread,
+// unknown_node if not announced (no system call)
+BOOST_FIBERS_DECL
+std::uint32_t announced_node() noexcept;
+
+// NUMA node the page containing vp is located on, unknown_node
+// if the page is not resident or if not supported
+BOOST_FIBERS_DECL
+std::uint32_t memory_node( void const* vp) noexcept;
+
+// sets the preferred NUMA node of the pages of [vp, vp + size),
+// returns false if not supported
+BOOST_FIBERS_DECL
+bool bind_memory( void * vp, std::size_t size, std::uint32_t node_id) noexcept;
+
+// moves the resident pages of [vp, vp + size) to NUMA node node_id
+// (pages not yet faulted in are skipped), returns the number of pages
+// moved to node_id, pages already located on node_id are not counted
+// (`0` if not supported)
+BOOST_FIBERS_DECL
+std::size_t migrate_memory( void * vp, std::size_t size, std::uint32_t node_id) noexcept;
+
+// allocates size bytes (page aligned) bound to NUMA node node_id; if
+// binding is not supported, only the top page is touched by the calling
+// thread (first-touch policy), throws std::bad_alloc
+BOOST_FIBERS_DECL
+void * allocate_memory( std::size_t size, std::uint32_t node_id);
+
+BOOST_FIBERS_DECL
+void deallocate_memory( void * vp, std::size_t size) noexcept;
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_NUMA_MEMORY_H
@@ -0,0 +1,244 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_NUMA_POOLED_FIXEDSIZE_STACK_H
+#define BOOST_FIBERS_NUMA_POOLED_FIXEDSIZE_STACK_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/context/stack_context.hpp>
+#include <boost/context/stack_traits.hpp>
+#include <boost/intrusive_ptr.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/cpu_relax.hpp>
+#include <boost/fiber/detail/spinlock.hpp>
+#include <boost/fiber/detail/stack_cache.hpp>
+#include <boost/fiber/numa/memory.hpp>
+#include <boost/fiber/numa/topology.hpp>
+#include <boost/fiber/stack_release.hpp>
+
+#if defined(BOOST_USE_VALGRIND)
+#include <valgrind/valgrind.h>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace numa {
+
+// stack allocator keeping the stacks on the NUMA node of the thread
+// allocating them: the memory of a stack is bound to the NUMA node of
+// the calling thread (current_node(), threads of numa::work_stealing
+// are pinned), free stacks are kept in a free list per NUMA node
+// a deallocated stack is returned to the free list of the NUMA node its
+// memory is bound to, even if the fiber has been stolen by a scheduler
+// running on another NUMA node; the ID of the node is stored at the
+// lowest address of the stack memory
+// the cold part of free stacks might be returned to the operating
+// system (stack_release_policy)
+template< typename traitsT >
+class basic_pooled_fixedsize_stack {
+private:
+    struct header {
+        std::uint32_t           node_id;
+        // pages released while the stack is free
+        bool                    released{ false };
+        // set while the pages are released outside of the lock
+        std::atomic< bool >     releasing{ false };
+
+        explicit header( std::uint32_t id) noexcept :
+            node_id{ id } {
+        }
+    };
+
+    // header occupies one cacheline below the usable stack
+    static constexpr std::size_t header_size = cacheline_length;
+
+    class storage {
+    private:
+        struct free_list {
+            detail::spinlock        splk{};
+            std::vector< void * >   stacks{};
+        };
+
+        std::atomic< std::size_t >          use_count_{ 0 };
+        const std::size_t                   stack_size_;
+        const std::size_t                   max_free_;
+        const stack_release_policy          release_;
+        const std::uint32_t                 node_count_;
+        std::unique_ptr< free_list[] >      lists_;
+
+        static std::uint32_t node_count_of( std::vector< node > const& topo) noexcept {
+            std::uint32_t max_id = 0;
+            for ( auto & n : topo) {
+                max_id = (std::max)( max_id, n.id);
+            }
+            return max_id + 1;
+        }
+
+    public:
+        storage( std::vector< node > const& topo, std::size_t stack_size, std::size_t max_free,
+                 stack_release_policy const& release) :
+            stack_size_{ stack_size },
+            max_free_{ max_free },
+            release_( release),
+            node_count_{ node_count_of( topo) },
+            lists_{ new free_list[node_count_] } {
+            BOOST_ASSERT( header_size < stack_size_);
+            BOOST_ASSERT( traits_type::is_unbounded() || ( traits_type::maximum_size() >= stack_size_) );
+        }
+
+        ~storage() {
+            for ( std::uint32_t i = 0; i < node_count_; ++i) {
+                for ( void * vp : lists_[i].stacks) {
+                    deallocate_memory( vp, stack_size_);
+                }
+            }
+        }
+
+        boost::context::stack_context allocate() {
+            std::uint32_t node_id = current_node();
+            if ( node_count_ <= node_id) {
+                node_id = 0;
+            }
+            void * vp = nullptr;
+            {
+                free_list & l = lists_[node_id];
+                detail::spinlock_lock lk{ l.splk };
+                if ( ! l.stacks.empty() ) {
+                    vp = l.stacks.back();
+                    l.stacks.pop_back();
+                }
+            }
+            if ( nullptr == vp) {
+                vp = allocate_memory( stack_size_, node_id);
+                ::new ( vp) header{ node_id };
+            } else {
+                // a concurrent deallocate() might still release the pages
+                while ( static_cast< header * >( vp)->releasing.load( std::memory_order_acquire) ) {
+                    cpu_relax();
+                }
+            }
+            static_cast< header * >( vp)->released = false;
+            boost::context::stack_context sctx;
+            sctx.size = stack_size_ - header_size;
+            sctx.sp = static_cast< char * >( vp) + stack_size_;
+#if defined(BOOST_USE_VALGRIND)
+            sctx.valgrind_stack_id = VALGRIND_STACK_REGISTER( sctx.sp, static_cast< char * >( vp) + header_size);
+#endif
+            return sctx;
+        }
+
+        void deallocate( boost::context::stack_context & sctx) noexcept {
+            BOOST_ASSERT( sctx.sp);
+#if defined(BOOST_USE_VALGRIND)
+            VALGRIND_STACK_DEREGISTER( sctx.valgrind_stack_id);
+#endif
+            void * vp = static_cast< char * >( sctx.sp) - stack_size_;
+            const std::uint32_t node_id = static_cast< header * >( vp)->node_id;
+            BOOST_ASSERT( node_id < node_count_);
+            free_list & l = lists_[node_id];
+            char * cold = nullptr;
+            {
+                detail::spinlock_lock lk{ l.splk };
+                if ( l.stacks.size() < max_free_) {
+                    try {
+                        l.stacks.push_back( vp);
+                        vp = nullptr;
+                        if ( release_.enabled && l.stacks.size() > release_.hysteresis) {
+                            // the stack falling out of the hot range
+                            // of the free list (LIFO) is released
+                            header * h = static_cast< header * >(
+                                    l.stacks[l.stacks.size() - 1 - release_.hysteresis]);
+                            if ( ! h->released) {
+                                h->released = true;
+                                h->releasing.store( true, std::memory_order_relaxed);
+                                cold = reinterpret_cast< char * >( h);
+                            }
+                        }
+                    } catch (...) {
+                    }
+                }
+            }
+            if ( nullptr != cold) {
+                // madvise() outside of the lock, allocate() waits
+                // if it takes the stack meanwhile
+                detail::release_stack_memory(
+                        cold + header_size, cold + stack_size_, release_.watermark, release_.lazy);
+                reinterpret_cast< header * >( cold)->releasing.store( false, std::memory_order_release);
+            }
+            if ( nullptr != vp) {
+                deallocate_memory( vp, stack_size_);
+            }
+        }
+
+        friend void intrusive_ptr_add_ref( storage * s) noexcept {
+            s->use_count_.fetch_add( 1, std::memory_order_relaxed);
+        }
+
+        friend void intrusive_ptr_release( storage * s) noexcept {
+            if ( 1 == s->use_count_.fetch_sub( 1, std::memory_order_acq_rel) ) {
+                delete s;
+            }
+        }
+    };
+
+    boost::intrusive_ptr< storage >     storage_;
+
+public:
+    typedef traitsT traits_type;
+
+    // max_free: max. number of free stacks kept per NUMA node
+    basic_pooled_fixedsize_stack( std::vector< node > const& topo,
+                                  std::size_t stack_size = traits_type::default_size(),
+                                  std::size_t max_free = 64,
+                                  stack_release_policy const& release = stack_release_policy{}) :
+        storage_{ new storage{ topo, stack_size, max_free, release } } {
+    }
+
+    boost::context::stack_context allocate() {
+        return storage_->allocate();
+    }
+
+    void deallocate( boost::context::stack_context & sctx) noexcept {
+        storage_->deallocate( sctx);
+    }
+};
+
+using pooled_fixedsize_stack = basic_pooled_fixedsize_stack< boost::context::stack_traits >;
+
+}
+
+namespace detail {
+
+// the stack of a fiber stolen by a scheduler running on another NUMA
+// node must not be cached by that scheduler, the stack is returned
+// to the free list of its NUMA node instead
+template< typename traitsT >
+struct is_stack_cacheable< numa::basic_pooled_fixedsize_stack< traitsT > > : public std::false_type {
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_NUMA_POOLED_FIXEDSIZE_STACK_H
@@ -8,6 +8,7 @@
 #define BOOST_FIBERS_NUMA_TOPOLOGY_H
 
 #include <cstdint>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -23,10 +24,24 @@ namespace boost {
 namespace fibers {
 namespace numa {
 
+// logical cpus sharing hardware resources with a logical cpu
+// (each set contains the logical cpu itself, empty if unknown)
+struct cpu_siblings {
+    // hardware threads of the same core (SMT)
+    std::set< std::uint32_t >       core;
+    // logical cpus sharing the L2 cache
+    std::set< std::uint32_t >       l2_cache;
+    // logical cpus sharing the L3 cache
+    std::set< std::uint32_t >       l3_cache;
+};
+
 struct node {
-    std::uint32_t                   id;
-    std::set< std::uint32_t >       logical_cpus;
-    std::vector< std::uint32_t >    distance;
+    std::uint32_t                                   id;
+    std::set< std::uint32_t >                       logical_cpus;
+    std::vector< std::uint32_t >                    distance;
+    // indexed by the logical cpus of the node,
+    // empty if the platform does not report it
+    std::map< std::uint32_t, cpu_siblings >         siblings;
 };
 
 inline
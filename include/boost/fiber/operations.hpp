@@ -83,6 +83,34 @@ void use_scheduling_algorithm( Args && ... args) noexcept {
         ->set_algo( new SchedAlgo( std::forward< Args >( args) ... ) );
 }
 
+inline
+void use_sleep_queue( sleep_queue_policy policy) {
+    boost::fibers::context::active()->get_scheduler()
+        ->set_sleep_queue_policy( policy);
+}
+
+inline
+scheduler_statistics get_statistics() noexcept {
+    return boost::fibers::context::active()->get_scheduler()->get_statistics();
+}
+
+inline
+void set_stack_cache_limits( std::size_t max_count, std::size_t max_bytes) noexcept {
+    boost::fibers::context::active()->get_scheduler()
+        ->set_stack_cache_limits( max_count, max_bytes);
+}
+
+inline
+void trim_stack_cache( std::size_t max_bytes = 0) noexcept {
+    boost::fibers::context::active()->get_scheduler()
+        ->trim_stack_cache( max_bytes);
+}
+
+inline
+void enable_tracing( bool enable = true) noexcept {
+    boost::fibers::context::active()->get_scheduler()->set_tracing( enable);
+}
+
 }}
 
 #ifdef BOOST_HAS_ABI_HEADERS
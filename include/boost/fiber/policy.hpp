@@ -25,6 +25,21 @@ enum class launch {
     post
 };
 
+enum class sleep_queue_policy {
+    ordered_set,
+    timer_wheel
+};
+
+// ready-queues of the schedulers of a stealing domain
+enum class ready_queue_policy {
+    // unbounded ring protected by a spinlock
+    spinlock,
+    // unbounded Chase-Lev deque
+    spmc,
+    // fixed-size ring, spills to the overflow queue of the domain
+    bounded
+};
+
 namespace detail {
 
 template< typename Fn >
@@ -0,0 +1,182 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_POOL_H
+#define BOOST_FIBERS_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/config.hpp>
+#if defined(BOOST_NO_CXX17_STD_APPLY)
+#include <boost/context/detail/apply.hpp>
+#endif
+
+#include <boost/fiber/buffered_channel.hpp>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/future/future.hpp>
+#include <boost/fiber/future/packaged_task.hpp>
+#include <boost/fiber/operations.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+#ifdef _MSC_VER
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+struct pool_task {
+    virtual ~pool_task() {}
+
+    virtual void run() = 0;
+};
+
+template< typename Fn, typename Tpl >
+class pool_task_impl : public pool_task {
+private:
+    Fn      fn_;
+    Tpl     arg_;
+
+public:
+    template< typename F >
+    pool_task_impl( F && fn, Tpl && arg) :
+        fn_( std::forward< F >( fn) ),
+        arg_( std::move( arg) ) {
+    }
+
+    void run() override final {
+#if defined(BOOST_NO_CXX17_STD_APPLY)
+       boost::context::detail::apply( std::move( fn_), std::move( arg_) );
+#else
+       std::apply( std::move( fn_), std::move( arg_) );
+#endif
+    }
+};
+
+}
+
+// a set of threads running fibers
+// each worker thread installs a scheduling algorithm and waits for
+// tasks submitted from any thread (fiber or not); each task
+// runs in its own fiber
+class BOOST_FIBERS_DECL pool {
+public:
+    // called in the worker thread with the index of the worker;
+    // has to install the scheduling algorithm
+    typedef std::function< void( std::uint32_t) >  initializer_type;
+
+private:
+    typedef std::unique_ptr< detail::pool_task >    task_ptr;
+
+    const std::uint32_t                 thread_count_;
+    initializer_type                    init_;
+    std::vector< std::uint32_t >        cpus_;
+    buffered_channel< task_ptr >        queue_;
+    std::mutex                          mtx_{};
+    // startup of the worker threads
+    std::condition_variable             started_cnd_{};
+    std::uint32_t                       started_{ 0 };
+    // drain of the submitted tasks
+    condition_variable_any              drained_cnd_{};
+    std::size_t                         pending_{ 0 };
+    bool                                shutdown_{ false };
+    std::vector< std::thread >          threads_{};
+
+    void worker_( std::uint32_t);
+
+    static void receive_( pool *);
+
+    static void run_( pool *, task_ptr);
+
+    void submit_( task_ptr);
+
+public:
+    // installs Algo, constructed from args, in each worker thread
+    template< typename Algo, typename ... Args >
+    static initializer_type algorithm( Args ... args) {
+        return [args...]( std::uint32_t) {
+            use_scheduling_algorithm< Algo >( args ...);
+        };
+    }
+
+    // worker i is pinned to cpus[i % cpus.size()] if cpus is not empty
+    pool( std::uint32_t thread_count,
+          initializer_type init,
+          std::vector< std::uint32_t > cpus = std::vector< std::uint32_t >{} );
+
+    pool( pool const&) = delete;
+    pool & operator=( pool const&) = delete;
+
+    // calls shutdown()
+    ~pool();
+
+    std::uint32_t thread_count() const noexcept {
+        return thread_count_;
+    }
+
+    // launches fn( args ...) as a detached fiber in one of the
+    // worker threads; might be called from any thread
+    // an exception escaping fn terminates the process (as for any fiber)
+    template< typename Fn, typename ... Args >
+    void post( Fn && fn, Args && ... args) {
+        typedef typename std::decay< Fn >::type                             fn_t;
+        typedef std::tuple< typename std::decay< Args >::type ... >         tpl_t;
+        submit_( task_ptr{
+            new detail::pool_task_impl< fn_t, tpl_t >{
+                std::forward< Fn >( fn),
+                tpl_t{ std::forward< Args >( args) ... } } } );
+    }
+
+    // as post(), the result (or exception) is returned via a future
+    template< typename Fn, typename ... Args >
+    future<
+        typename std::result_of<
+            typename std::decay< Fn >::type( typename std::decay< Args >::type ... )
+        >::type
+    >
+    submit( Fn && fn, Args && ... args) {
+        typedef typename std::result_of<
+            typename std::decay< Fn >::type( typename std::decay< Args >::type ... )
+        >::type     result_type;
+
+        packaged_task< result_type( typename std::decay< Args >::type ... ) > pt{
+            std::forward< Fn >( fn) };
+        future< result_type > f{ pt.get_future() };
+        post( std::move( pt), std::forward< Args >( args) ... );
+        return f;
+    }
+
+    // rejects new tasks, waits till all submitted tasks are complete
+    // and joins the worker threads; must not be called from a worker thread
+    void shutdown();
+};
+
+}}
+
+#ifdef _MSC_VER
+# pragma warning(pop)
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_POOL_H
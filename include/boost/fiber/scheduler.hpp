@@ -6,6 +6,7 @@
 #ifndef BOOST_FIBERS_FIBER_MANAGER_H
 #define BOOST_FIBERS_FIBER_MANAGER_H
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -22,8 +23,15 @@
 #include <boost/fiber/algo/algorithm.hpp>
 #include <boost/fiber/context.hpp>
 #include <boost/fiber/detail/config.hpp>
+#include <boost/fiber/detail/context_mpsc_queue.hpp>
 #include <boost/fiber/detail/data.hpp>
 #include <boost/fiber/detail/spinlock.hpp>
+#include <boost/fiber/detail/stack_cache.hpp>
+#include <boost/fiber/detail/timer_wheel.hpp>
+#include <boost/fiber/policy.hpp>
+#include <boost/fiber/statistics.hpp>
+#include <boost/fiber/trace.hpp>
+#include <boost/fiber/watchdog.hpp>
 
 #ifdef BOOST_HAS_ABI_HEADERS
 #  include BOOST_ABI_PREFIX
@@ -38,6 +46,9 @@ namespace boost {
 namespace fibers {
 
 class BOOST_FIBERS_DECL scheduler {
+private:
+    friend class watchdog;
+
 public:
     struct timepoint_less {
         bool operator()( context const& l, context const& r) const noexcept {
@@ -72,42 +83,68 @@ private:
                 intrusive::linear< true >,
                 intrusive::cache_last< true >
             >                                               terminated_queue_type;
-    typedef intrusive::slist<
-                context,
-                intrusive::member_hook<
-                    context, detail::remote_ready_hook, & context::remote_ready_hook_ >,
-                intrusive::linear< true >,
-                intrusive::cache_last< true >
-            >                                               remote_ready_queue_type;
 
 #if ! defined(BOOST_FIBERS_NO_ATOMICS)
     // remote ready-queue contains context' signaled by schedulers
-    // running in other threads
-    detail::spinlock                                            remote_ready_splk_{};
-    remote_ready_queue_type                                     remote_ready_queue_{};
+    // running in other threads (lock-free, multi-producer/single-consumer)
+    detail::context_mpsc_queue                                  remote_ready_queue_{};
+    // set while the dispatcher is (about to be) suspended in
+    // algorithm::suspend_until(); algorithm::notify() is
+    // called by schedule_from_remote() only if set (read after
+    // the push, thus only while remote_producers_ is held)
+    std::atomic< bool >                                         parked_{ false };
+    // count of schedule_from_remote() calls still touching this
+    // scheduler, drained by ~scheduler()
+    std::atomic< std::size_t >                                  remote_producers_{ 0 };
 #endif
     algo::algorithm::ptr_t             algo_;
     // sleep-queue contains context' which have been called
     // scheduler::wait_until()
     sleep_queue_type                                            sleep_queue_{};
+    // timing wheel, used as sleep-queue instead of sleep_queue_
+    // if sleep_queue_policy::timer_wheel has been selected
+    std::unique_ptr< detail::timer_wheel >                      sleep_wheel_{};
     // worker-queue contains all context' mananged by this scheduler
     // except main-context and dispatcher-context
     // unlink happens on destruction of a context
     worker_queue_type                                           worker_queue_{};
     // terminated-queue contains context' which have been terminated
     terminated_queue_type                                       terminated_queue_{};
+    // runtime counters, written by the thread running the scheduler
+    detail::scheduler_counters                                  counters_{};
+    // stacks of terminated worker-context', reused by new fibers
+    detail::stack_cache                                         stack_cache_{};
+    // events are recorded if set, see trace()
+    std::atomic< bool >                                         tracing_{
+#if defined(BOOST_FIBERS_ENABLE_TRACING)
+        true
+#else
+        false
+#endif
+    };
+    // context switches are stamped while watched by a watchdog
+    detail::run_stamp                                           run_stamp_{};
+    std::atomic< bool >                                         watched_{ false };
+    // protected by the registry of the watchdogs
+    watchdog                                                *   watchdog_{ nullptr };
     intrusive_ptr< context >                                    dispatcher_ctx_{};
     context                                                 *   main_ctx_{ nullptr };
     bool                                                        shutdown_{ false };
 
     void release_terminated_() noexcept;
 
+    void sleep_link_( context *) noexcept;
+
+    void sleep_expired_( context *) noexcept;
+
 #if ! defined(BOOST_FIBERS_NO_ATOMICS)
     void remote_ready2ready_() noexcept;
 #endif
 
     void sleep2ready_() noexcept;
 
+    void suspend_until_( std::chrono::steady_clock::time_point const&) noexcept;
+
 public:
     scheduler() noexcept;
 
@@ -141,6 +178,61 @@ public:
 
     void set_algo( algo::algorithm::ptr_t) noexcept;
 
+    void set_sleep_queue_policy( sleep_queue_policy);
+
+    sleep_queue_policy get_sleep_queue_policy() const noexcept {
+        return sleep_wheel_ ? sleep_queue_policy::timer_wheel : sleep_queue_policy::ordered_set;
+    }
+
+    detail::scheduler_counters & get_counters() noexcept {
+        return counters_;
+    }
+
+    // might be called from any thread
+    scheduler_statistics get_statistics() const noexcept;
+
+    void set_tracing( bool enable) noexcept {
+        tracing_.store( enable, std::memory_order_relaxed);
+    }
+
+    bool is_tracing() const noexcept {
+        return tracing_.load( std::memory_order_relaxed);
+    }
+
+    // might be called from any thread, the event is recorded
+    // in the trace buffer of the calling thread
+    void trace( trace_event ev, context const* ctx) noexcept {
+#if ! defined(BOOST_FIBERS_NO_TRACING)
+        if ( BOOST_UNLIKELY( tracing_.load( std::memory_order_relaxed) ) ) {
+            detail::trace( ev, ctx);
+        }
+#else
+        (void)ev;
+        (void)ctx;
+#endif
+    }
+
+    // remember when ctx has been resumed, see watchdog
+    void stamp_resume( context * ctx) noexcept {
+        if ( BOOST_UNLIKELY( watched_.load( std::memory_order_relaxed) ) ) {
+            // the dispatcher-context never stalls the application
+            run_stamp_.stamp( ctx->is_context( type::dispatcher_context) ? nullptr : ctx);
+        }
+    }
+
+    // nullptr while the scheduler is shutting down
+    detail::stack_cache * get_stack_cache() noexcept {
+        return shutdown_ ? nullptr : & stack_cache_;
+    }
+
+    void set_stack_cache_limits( std::size_t max_count, std::size_t max_bytes) noexcept {
+        stack_cache_.set_limits( max_count, max_bytes);
+    }
+
+    void trim_stack_cache( std::size_t max_bytes = 0) noexcept {
+        stack_cache_.trim( max_bytes);
+    }
+
     void attach_main_context( context *) noexcept;
 
     void attach_dispatcher_context( intrusive_ptr< context >) noexcept;
@@ -0,0 +1,139 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_STACK_PROFILE_H
+#define BOOST_FIBERS_STACK_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if ! defined(BOOST_NO_RTTI)
+# include <typeinfo>
+#endif
+
+#include <boost/config.hpp>
+#include <boost/context/protected_fixedsize_stack.hpp>
+#include <boost/context/stack_context.hpp>
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+# include <boost/context/segmented_stack.hpp>
+#endif
+
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+
+// stack usage of the terminated fibers per stack allocator type and stack size
+struct stack_usage {
+    // demangled type of the stack allocator (empty if RTTI is disabled)
+    std::string                 allocator{};
+    // usable bytes of a stack
+    std::size_t                 stack_size{ 0 };
+    // profiled fibers
+    std::uint64_t               fibers{ 0 };
+    // deepest offset (from the top of the stack) touched by a fiber
+    std::size_t                 max_used{ 0 };
+    // mean of the deepest offsets
+    std::size_t                 mean_used{ 0 };
+};
+
+// if enabled, the stacks of new fibers are filled with a pattern and
+// scanned for the deepest touched offset if the fiber terminates
+// (the whole stack is committed, intended for profiling runs)
+BOOST_FIBERS_DECL
+void enable_stack_profiling( bool = true) noexcept;
+
+BOOST_FIBERS_DECL
+bool stack_profiling_enabled() noexcept;
+
+BOOST_FIBERS_DECL
+std::vector< stack_usage > get_stack_usage();
+
+BOOST_FIBERS_DECL
+void reset_stack_usage() noexcept;
+
+// writes a table of get_stack_usage()
+BOOST_FIBERS_DECL
+void write_stack_usage( std::ostream &);
+
+namespace detail {
+
+// stack allocator of profiled fibers
+struct stack_profile_site {
+    char const      *   name;
+    // bytes at the bottom of a stack that must not be touched
+    std::size_t         guard_size;
+};
+
+template< typename StackAlloc >
+struct stack_guard_size {
+    static std::size_t size() noexcept {
+        return 0;
+    }
+};
+
+template< typename traitsT >
+struct stack_guard_size< boost::context::basic_protected_fixedsize_stack< traitsT > > {
+    static std::size_t size() noexcept {
+        return traitsT::page_size();
+    }
+};
+
+template< typename StackAlloc >
+stack_profile_site const* stack_profile_site_of() noexcept {
+    static const stack_profile_site site{
+#if ! defined(BOOST_NO_RTTI)
+        typeid( StackAlloc).name(),
+#else
+        "",
+#endif
+        stack_guard_size< StackAlloc >::size() };
+    return & site;
+}
+
+// fills [bottom, top) with the pattern
+BOOST_FIBERS_DECL
+void fill_stack( void * bottom, void * top) noexcept;
+
+// records the deepest word of [bottom, top) not equal to the pattern
+BOOST_FIBERS_DECL
+void record_stack_usage( stack_profile_site const*, void * bottom, void * top) noexcept;
+
+// called before the context is placed on the stack; returns
+// nullptr if profiling is disabled
+template< typename StackAlloc >
+stack_profile_site const* prepare_stack_profile( boost::context::stack_context const& sctx) noexcept {
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+    if ( std::is_same< StackAlloc, boost::context::segmented_stack >::value) {
+        return nullptr;
+    }
+#endif
+    if ( BOOST_LIKELY( ! stack_profiling_enabled() ) ) {
+        return nullptr;
+    }
+    stack_profile_site const* site = stack_profile_site_of< StackAlloc >();
+    if ( sctx.size <= site->guard_size) {
+        return nullptr;
+    }
+    fill_stack( static_cast< char * >( sctx.sp) - sctx.size + site->guard_size, sctx.sp);
+    return site;
+}
+
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_STACK_PROFILE_H
@@ -0,0 +1,56 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_STACK_RELEASE_H
+#define BOOST_FIBERS_STACK_RELEASE_H
+
+#include <cstddef>
+
+#include <boost/config.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+
+// the cold part of a free stack kept by a pooling stack allocator is
+// returned to the operating system: the pages below the top `watermark`
+// bytes are released lazily (MADV_FREE, MADV_DONTNEED if not available)
+// or eagerly (MADV_DONTNEED)
+// the `hysteresis` most recently returned stacks are not released, thus
+// stacks reused immediately are not faulted in again; a stack is released
+// at most once while it is free
+struct stack_release_policy {
+    // stacks are not released by default
+    bool                enabled{ false };
+    // bytes at the top of a free stack kept resident
+    std::size_t         watermark{ 16 * 1024 };
+    // number of most recently returned stacks kept resident
+    std::size_t         hysteresis{ 4 };
+    // released pages are reclaimed by the kernel on demand (MADV_FREE),
+    // otherwise immediately (MADV_DONTNEED, the RSS drops at once)
+    bool                lazy{ true };
+};
+
+namespace detail {
+
+// releases the pages of [bottom, top - watermark) (inner pages only),
+// returns false if not supported
+BOOST_FIBERS_DECL
+bool release_stack_memory( void * bottom, void * top, std::size_t watermark, bool lazy = true) noexcept;
+
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_STACK_RELEASE_H
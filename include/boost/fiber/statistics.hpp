@@ -0,0 +1,134 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_STATISTICS_H
+#define BOOST_FIBERS_STATISTICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/config.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+
+// snapshot of the counters of a scheduler and its scheduling algorithm
+// counters are monotonic, compute rates from the difference of two snapshots
+struct scheduler_statistics {
+    // switches to another context (fiber, dispatcher or main context)
+    std::uint64_t                           context_switches{ 0 };
+    // fibers launched via this scheduler
+    std::uint64_t                           fibers_spawned{ 0 };
+    // fibers terminated while running on this scheduler
+    std::uint64_t                           fibers_terminated{ 0 };
+    // fibers made ready by this thread
+    std::uint64_t                           local_wakeups{ 0 };
+    // fibers made ready by other threads
+    std::uint64_t                           remote_wakeups{ 0 };
+    // work_stealing, numa::work_stealing: tries to steal from another scheduler
+    std::uint64_t                           steal_attempts{ 0 };
+    // work_stealing, numa::work_stealing: successful steals (a steal might move several fibers)
+    std::uint64_t                           steal_successes{ 0 };
+    // numa::work_stealing: successful steals from a remote NUMA node
+    std::uint64_t                           remote_steal_successes{ 0 };
+    // numa::work_stealing: fibers whose stack memory has been migrated to the local NUMA node
+    std::uint64_t                           stack_migrations{ 0 };
+    // numa::work_stealing: pages located on the local NUMA node after a migration
+    std::uint64_t                           migrated_pages{ 0 };
+    // calls of algorithm::suspend_until()
+    std::uint64_t                           parks{ 0 };
+    // calls of algorithm::notify() from other threads
+    std::uint64_t                           unparks{ 0 };
+    // time spent in algorithm::suspend_until()
+    std::chrono::steady_clock::duration     park_time{ 0 };
+    // max. number of fibers in the ready-queue of the built-in algorithms
+    std::size_t                             ready_queue_high_water_mark{ 0 };
+};
+
+namespace detail {
+
+// counter written by one thread (relaxed, no read-modify-write)
+// and read by any thread
+class statistics_counter {
+private:
+    std::atomic< std::uint64_t >    value_{ 0 };
+
+public:
+    statistics_counter() = default;
+
+    statistics_counter( statistics_counter const&) = delete;
+    statistics_counter & operator=( statistics_counter const&) = delete;
+
+    void increment( std::uint64_t n = 1) noexcept {
+        value_.store( value_.load( std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void update_max( std::uint64_t n) noexcept {
+        if ( n > value_.load( std::memory_order_relaxed) ) {
+            value_.store( n, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t load() const noexcept {
+        return value_.load( std::memory_order_relaxed);
+    }
+};
+
+// counters maintained by a scheduler; the counters of the built-in
+// sched-algorithms are kept here too (updated through the scheduler of the
+// context), so that a snapshot does not access the sched-algorithm,
+// which might be replaced by set_algo() meanwhile
+struct scheduler_counters {
+    statistics_counter                  context_switches{};
+    statistics_counter                  fibers_spawned{};
+    statistics_counter                  fibers_terminated{};
+    statistics_counter                  local_wakeups{};
+    statistics_counter                  remote_wakeups{};
+    statistics_counter                  steal_attempts{};
+    statistics_counter                  steal_successes{};
+    statistics_counter                  remote_steal_successes{};
+    statistics_counter                  stack_migrations{};
+    statistics_counter                  migrated_pages{};
+    statistics_counter                  ready_queue_high_water_mark{};
+    statistics_counter                  parks{};
+    // nanoseconds
+    statistics_counter                  park_time{};
+    // incremented by other threads
+    std::atomic< std::uint64_t >        unparks{ 0 };
+
+    void snapshot( scheduler_statistics & stats) const noexcept {
+        stats.context_switches = context_switches.load();
+        stats.fibers_spawned = fibers_spawned.load();
+        stats.fibers_terminated = fibers_terminated.load();
+        stats.local_wakeups = local_wakeups.load();
+        stats.remote_wakeups = remote_wakeups.load();
+        stats.steal_attempts = steal_attempts.load();
+        stats.steal_successes = steal_successes.load();
+        stats.remote_steal_successes = remote_steal_successes.load();
+        stats.stack_migrations = stack_migrations.load();
+        stats.migrated_pages = migrated_pages.load();
+        stats.ready_queue_high_water_mark = static_cast< std::size_t >( ready_queue_high_water_mark.load() );
+        stats.parks = parks.load();
+        stats.park_time = std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                std::chrono::nanoseconds( park_time.load() ) );
+        stats.unparks = unparks.load( std::memory_order_relaxed);
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_STATISTICS_H
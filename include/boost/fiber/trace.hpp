@@ -0,0 +1,70 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_TRACE_H
+#define BOOST_FIBERS_TRACE_H
+
+#include <cstdint>
+#include <iosfwd>
+
+#include <boost/config.hpp>
+
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+
+class context;
+
+enum class trace_event : std::uint8_t {
+    // fiber launched
+    spawn = 0,
+    // context resumed (starts running on the thread)
+    resume,
+    // context suspended (stops running on the thread)
+    suspend,
+    // fiber blocked on a synchronization primitive or timeout
+    block,
+    // fiber made ready by this thread
+    wake,
+    // fiber made ready by another thread
+    remote_wake,
+    // fiber stolen from another scheduler
+    steal,
+    // fiber terminated
+    terminate,
+    // thread parked in algorithm::suspend_until()
+    park,
+    // thread returned from algorithm::suspend_until()
+    unpark
+};
+
+// drains the trace buffers of all threads and writes the events
+// as Chrome trace event format (JSON, chrome://tracing or Perfetto)
+// running contexts are written as duration events, all other
+// events as instant events
+BOOST_FIBERS_DECL
+void write_chrome_trace( std::ostream &);
+
+namespace detail {
+
+// append an event to the trace buffer of the calling thread
+// lock-free, the event is dropped if the buffer is full
+BOOST_FIBERS_DECL
+void trace( trace_event, context const*) noexcept;
+
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_TRACE_H
@@ -0,0 +1,149 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_FIBERS_WATCHDOG_H
+#define BOOST_FIBERS_WATCHDOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/config.hpp>
+
+#include <boost/fiber/context.hpp>
+#include <boost/fiber/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+#ifdef _MSC_VER
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace boost {
+namespace fibers {
+
+class scheduler;
+
+namespace detail {
+
+// context running on a scheduler and the time it was resumed
+// written by the thread running the scheduler at each context switch,
+// read by the watchdog thread (sequence lock, writer never waits)
+class run_stamp {
+private:
+    std::atomic< std::uint64_t >    seq_{ 0 };
+    std::atomic< context * >        ctx_{ nullptr };
+    std::atomic< std::int64_t >     since_{ 0 };
+
+public:
+    run_stamp() = default;
+
+    run_stamp( run_stamp const&) = delete;
+    run_stamp & operator=( run_stamp const&) = delete;
+
+    void stamp( context * ctx) noexcept {
+        const std::uint64_t seq = seq_.load( std::memory_order_relaxed);
+        seq_.store( seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence( std::memory_order_release);
+        ctx_.store( ctx, std::memory_order_relaxed);
+        since_.store( std::chrono::duration_cast< std::chrono::nanoseconds >(
+                    std::chrono::steady_clock::now().time_since_epoch() ).count(),
+                std::memory_order_relaxed);
+        seq_.store( seq + 2, std::memory_order_release);
+    }
+
+    // returns false if a context switch is in progress
+    bool read( std::uint64_t & seq, context *& ctx,
+               std::chrono::steady_clock::time_point & since) const noexcept {
+        seq = seq_.load( std::memory_order_acquire);
+        if ( 0 != ( seq & 1) ) {
+            return false;
+        }
+        ctx = ctx_.load( std::memory_order_relaxed);
+        const std::int64_t ns = since_.load( std::memory_order_relaxed);
+        std::atomic_thread_fence( std::memory_order_acquire);
+        if ( seq != seq_.load( std::memory_order_relaxed) ) {
+            return false;
+        }
+        since = std::chrono::steady_clock::time_point{
+            std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                    std::chrono::nanoseconds( ns) ) };
+        return true;
+    }
+};
+
+}
+
+// reports fibers (including the main-context) running longer than
+// a threshold without a context switch, i.e. fibers that do not yield
+// and so stall all other fibers of their thread
+// the check is done by a helper thread, the handler is called
+// from the helper thread once per resumption of the culprit
+class BOOST_FIBERS_DECL watchdog {
+public:
+    typedef std::function<
+        void( context::id, std::thread::id, std::chrono::steady_clock::duration)
+    >                                                       handler_type;
+
+private:
+    friend class scheduler;
+
+    struct entry {
+        scheduler       *   sched;
+        std::thread::id     thread;
+        std::uint64_t       reported;
+    };
+
+    std::chrono::steady_clock::duration     threshold_;
+    handler_type                            handler_;
+    // protected by a mutex shared by all watchdogs
+    std::vector< entry >                    entries_{};
+    std::mutex                              mtx_{};
+    std::condition_variable                 cnd_{};
+    bool                                    stop_{ false };
+    std::thread                             thread_{};
+
+    void run_();
+
+    // called by ~scheduler()
+    static void detach_( scheduler *) noexcept;
+
+public:
+    watchdog( std::chrono::steady_clock::duration threshold, handler_type handler);
+
+    watchdog( watchdog const&) = delete;
+    watchdog & operator=( watchdog const&) = delete;
+
+    ~watchdog();
+
+    // watch the scheduler running in the calling thread
+    void watch();
+
+    void unwatch() noexcept;
+
+    std::chrono::steady_clock::duration threshold() const noexcept {
+        return threshold_;
+    }
+};
+
+}}
+
+#ifdef _MSC_VER
+# pragma warning(pop)
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_FIBERS_WATCHDOG_H
@@ -0,0 +1,133 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// skynet (detached fibers) on work_stealing for fixedsize_stack and
+// caching_fixedsize_stack (pooled_fixedsize_stack is not thread safe);
+// fibers are created by one thread and might terminate on another thread
+// (stolen), each run uses a new domain and new threads
+// (based on https://github.com/atemerev/skynet from Alexander Temerev)
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+#include <boost/predef.h>
+
+#include "barrier.hpp"
+
+using clock_type = std::chrono::steady_clock;
+using duration_type = clock_type::duration;
+using time_point_type = clock_type::time_point;
+using channel_type = boost::fibers::buffered_channel< std::uint64_t >;
+using lock_type = std::unique_lock< std::mutex >;
+using domain_type = boost::fibers::algo::stealing_domain;
+
+struct run_state {
+    bool                                    done{ false };
+    std::mutex                              mtx{};
+    boost::fibers::condition_variable_any   cnd{};
+    duration_type                           duration{};
+};
+
+// microbenchmark
+template< typename Allocator >
+void skynet( Allocator & salloc, channel_type & c, std::size_t num, std::size_t size, std::size_t div) {
+    if ( 1 == size) {
+        c.push( num);
+    } else {
+        channel_type rc{ 16 };
+        for ( std::size_t i = 0; i < div; ++i) {
+            auto sub_num = num + i * size / div;
+            boost::fibers::fiber{ boost::fibers::launch::dispatch,
+                              std::allocator_arg, salloc,
+                              skynet< Allocator >,
+                              std::ref( salloc), std::ref( rc), sub_num, size / div, div }.detach();
+        }
+        std::uint64_t sum{ 0 };
+        for ( std::size_t i = 0; i < div; ++i) {
+            sum += rc.value_pop();
+        }
+        c.push( sum);
+    }
+}
+
+void worker( std::shared_ptr< domain_type > domain, barrier * b, run_state * s) {
+    // thread registers itself at work-stealing scheduler
+    boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain);
+    b->wait();
+    lock_type lk( s->mtx);
+    s->cnd.wait( lk, [s](){ return s->done; });
+}
+
+template< typename Allocator >
+void driver( std::shared_ptr< domain_type > domain, barrier * b, run_state * s, Allocator salloc) {
+    boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain);
+    std::size_t size{ 1000000 };
+    std::size_t div{ 10 };
+    channel_type rc{ 2 };
+    b->wait();
+    time_point_type start{ clock_type::now() };
+    skynet( salloc, rc, 0, size, div);
+    std::uint64_t result = rc.value_pop();
+    s->duration = clock_type::now() - start;
+    if ( 499999500000 != result) {
+        throw std::runtime_error("invalid result");
+    }
+    lock_type lk( s->mtx);
+    s->done = true;
+    lk.unlock();
+    s->cnd.notify_all();
+}
+
+template< typename Allocator >
+void run( std::uint32_t thread_count, Allocator salloc, char const* name) {
+    auto domain = std::make_shared< domain_type >( thread_count);
+    run_state s;
+    barrier b{ thread_count };
+    std::vector< std::thread > threads;
+    for ( std::uint32_t i = 1 /* count driver-thread */; i < thread_count; ++i) {
+        threads.emplace_back( worker, domain, & b, & s);
+    }
+    threads.emplace_back( driver< Allocator >, domain, & b, & s, salloc);
+    for ( std::thread & t : threads) {
+        t.join();
+    }
+    std::cout << std::left << std::setw( 24) << name
+              << std::right << std::setw( 8) << s.duration.count() / 1000000 << " ms" << std::endl;
+}
+
+int main() {
+    try {
+        // count of logical cpus
+        std::uint32_t thread_count = std::thread::hardware_concurrency();
+        std::cout << "threads: " << thread_count << std::endl;
+        // Windows 10 and FreeBSD require a fiber stack of 8kb
+        // otherwise the stack gets exhausted
+        // stack requirements must be checked for other OS too
+#if BOOST_OS_WINDOWS || BOOST_OS_BSD
+        const std::size_t stack_size = 2*boost::context::stack_traits::page_size();
+#else
+        const std::size_t stack_size = boost::context::stack_traits::page_size();
+#endif
+        run( thread_count, boost::fibers::fixedsize_stack{ stack_size }, "fixedsize_stack");
+        run( thread_count, boost::fibers::caching_fixedsize_stack{ stack_size }, "caching_fixedsize_stack");
+        return EXIT_SUCCESS;
+    } catch ( std::exception const& e) {
+        std::cerr << "exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unhandled exception" << std::endl;
+    }
+	return EXIT_FAILURE;
+}
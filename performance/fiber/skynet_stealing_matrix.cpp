@@ -0,0 +1,191 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// skynet on work_stealing for each ready_queue_policy, fibers are
+// detached or joined; each run uses a new domain and new threads
+// (based on https://github.com/atemerev/skynet from Alexander Temerev)
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+#include <boost/predef.h>
+
+#include "barrier.hpp"
+
+using clock_type = std::chrono::steady_clock;
+using duration_type = clock_type::duration;
+using time_point_type = clock_type::time_point;
+using channel_type = boost::fibers::buffered_channel< std::uint64_t >;
+using allocator_type = boost::fibers::fixedsize_stack;
+using lock_type = std::unique_lock< std::mutex >;
+using domain_type = boost::fibers::algo::stealing_domain;
+
+struct run_state {
+    bool                                    done{ false };
+    std::mutex                              mtx{};
+    boost::fibers::condition_variable_any   cnd{};
+    std::uint64_t                           steal_attempts{ 0 };
+    std::uint64_t                           steal_successes{ 0 };
+    duration_type                           duration{};
+
+    void collect() {
+        boost::fibers::scheduler_statistics stats = boost::fibers::get_statistics();
+        lock_type lk( mtx);
+        steal_attempts += stats.steal_attempts;
+        steal_successes += stats.steal_successes;
+    }
+};
+
+// microbenchmark
+void skynet_detach( allocator_type & salloc, channel_type & c, std::size_t num, std::size_t size, std::size_t div) {
+    if ( 1 == size) {
+        c.push( num);
+    } else {
+        channel_type rc{ 16 };
+        for ( std::size_t i = 0; i < div; ++i) {
+            auto sub_num = num + i * size / div;
+            boost::fibers::fiber{ boost::fibers::launch::dispatch,
+                              std::allocator_arg, salloc,
+                              skynet_detach,
+                              std::ref( salloc), std::ref( rc), sub_num, size / div, div }.detach();
+        }
+        std::uint64_t sum{ 0 };
+        for ( std::size_t i = 0; i < div; ++i) {
+            sum += rc.value_pop();
+        }
+        c.push( sum);
+    }
+}
+
+void skynet_join( allocator_type & salloc, channel_type & c, std::size_t num, std::size_t size, std::size_t div) {
+    if ( 1 == size) {
+        c.push( num);
+    } else {
+        channel_type rc{ 16 };
+        std::vector< boost::fibers::fiber > fibers;
+        for ( std::size_t i = 0; i < div; ++i) {
+            auto sub_num = num + i * size / div;
+            fibers.emplace_back( boost::fibers::launch::dispatch,
+                                 std::allocator_arg, salloc,
+                                 skynet_join,
+                                 std::ref( salloc), std::ref( rc), sub_num, size / div, div);
+        }
+        std::uint64_t sum{ 0 };
+        for ( std::size_t i = 0; i < div; ++i) {
+            sum += rc.value_pop();
+        }
+        c.push( sum);
+        for ( auto & f : fibers) {
+            f.join();
+        }
+    }
+}
+
+typedef void ( * skynet_type)( allocator_type &, channel_type &, std::size_t, std::size_t, std::size_t);
+
+void worker( std::shared_ptr< domain_type > domain, barrier * b, run_state * s) {
+    // thread registers itself at work-stealing scheduler
+    boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain);
+    b->wait();
+    lock_type lk( s->mtx);
+    s->cnd.wait( lk, [s](){ return s->done; });
+    lk.unlock();
+    s->collect();
+}
+
+void driver( std::shared_ptr< domain_type > domain, barrier * b, run_state * s, skynet_type fn) {
+    boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain);
+    std::size_t size{ 1000000 };
+    std::size_t div{ 10 };
+    // Windows 10 and FreeBSD require a fiber stack of 8kb
+    // otherwise the stack gets exhausted
+    // stack requirements must be checked for other OS too
+#if BOOST_OS_WINDOWS || BOOST_OS_BSD
+    allocator_type salloc{ 2*allocator_type::traits_type::page_size() };
+#else
+    allocator_type salloc{ allocator_type::traits_type::page_size() };
+#endif
+    channel_type rc{ 2 };
+    b->wait();
+    time_point_type start{ clock_type::now() };
+    fn( salloc, rc, 0, size, div);
+    std::uint64_t result = rc.value_pop();
+    s->duration = clock_type::now() - start;
+    if ( 499999500000 != result) {
+        throw std::runtime_error("invalid result");
+    }
+    lock_type lk( s->mtx);
+    s->done = true;
+    lk.unlock();
+    s->cnd.notify_all();
+    s->collect();
+}
+
+void run( std::uint32_t thread_count, boost::fibers::ready_queue_policy policy,
+          char const* policy_name, skynet_type fn, char const* fn_name) {
+    auto domain = std::make_shared< domain_type >( thread_count, policy);
+    run_state s;
+    barrier b{ thread_count };
+    std::vector< std::thread > threads;
+    for ( std::uint32_t i = 1 /* count driver-thread */; i < thread_count; ++i) {
+        threads.emplace_back( worker, domain, & b, & s);
+    }
+    threads.emplace_back( driver, domain, & b, & s, fn);
+    for ( std::thread & t : threads) {
+        t.join();
+    }
+    std::cout << std::left << std::setw( 10) << policy_name
+              << std::setw( 8) << fn_name
+              << std::right << std::setw( 8) << s.duration.count() / 1000000 << " ms"
+              << std::setw( 12) << s.steal_attempts
+              << std::setw( 12) << s.steal_successes;
+    if ( 0 != s.steal_attempts) {
+        std::cout << std::setw( 9) << std::fixed << std::setprecision( 1)
+                  << ( 100. * s.steal_successes) / s.steal_attempts << "%";
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    try {
+        // count of logical cpus
+        std::uint32_t thread_count = std::thread::hardware_concurrency();
+        std::cout << "threads: " << thread_count << std::endl;
+        std::cout << std::left << std::setw( 10) << "policy"
+                  << std::setw( 8) << "skynet"
+                  << std::right << std::setw( 11) << "duration"
+                  << std::setw( 12) << "attempts"
+                  << std::setw( 12) << "successes"
+                  << std::setw( 10) << "rate" << std::endl;
+        const struct {
+            boost::fibers::ready_queue_policy   policy;
+            char const*                         name;
+        } policies[] = {
+            { boost::fibers::ready_queue_policy::spinlock, "spinlock" },
+            { boost::fibers::ready_queue_policy::spmc, "spmc" },
+            { boost::fibers::ready_queue_policy::bounded, "bounded" } };
+        for ( auto & p : policies) {
+            run( thread_count, p.policy, p.name, skynet_detach, "detach");
+            run( thread_count, p.policy, p.name, skynet_join, "join");
+        }
+        return EXIT_SUCCESS;
+    } catch ( std::exception const& e) {
+        std::cerr << "exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unhandled exception" << std::endl;
+    }
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,132 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// compares the sleep-queue implementations of the scheduler
+//  - sleep: many fibers parked on short timeouts (insert + expire)
+//  - cancel: timed channel ops that are satisfied before the timeout (insert + cancel)
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+#include <boost/predef.h>
+
+using clock_type = std::chrono::steady_clock;
+using duration_type = clock_type::duration;
+using time_point_type = clock_type::time_point;
+using channel_type = boost::fibers::buffered_channel< std::uint64_t >;
+using allocator_type = boost::fibers::fixedsize_stack;
+
+static std::size_t fibers_count{ 100000 };
+static std::size_t sleep_rounds{ 10 };
+static std::size_t cancel_rounds{ 100 };
+
+void sleeper( std::uint32_t seed) {
+    std::minstd_rand generator{ seed };
+    std::uniform_int_distribution< int > distribution{ 1, 50 };
+    for ( std::size_t i = 0; i < sleep_rounds; ++i) {
+        boost::this_fiber::sleep_for( std::chrono::milliseconds( distribution( generator) ) );
+    }
+}
+
+void ping( channel_type & in, channel_type & out) {
+    std::uint64_t value = 0;
+    for ( std::size_t i = 0; i < cancel_rounds; ++i) {
+        out.push( value);
+        // timeout is never reached, context is removed from sleep-queue
+        if ( boost::fibers::channel_op_status::success != in.pop_wait_for( value, std::chrono::seconds( 10) ) ) {
+            throw std::runtime_error("timeout");
+        }
+        ++value;
+    }
+}
+
+void pong( channel_type & in, channel_type & out) {
+    std::uint64_t value = 0;
+    for ( std::size_t i = 0; i < cancel_rounds; ++i) {
+        if ( boost::fibers::channel_op_status::success != in.pop_wait_for( value, std::chrono::seconds( 10) ) ) {
+            throw std::runtime_error("timeout");
+        }
+        out.push( value);
+    }
+}
+
+template< typename Fn >
+void measure( char const* name, Fn && fn) {
+    time_point_type start{ clock_type::now() };
+    std::clock_t cpu_start = std::clock();
+    fn();
+    std::clock_t cpu = std::clock() - cpu_start;
+    duration_type duration = clock_type::now() - start;
+    std::cout << name << ": duration " << std::chrono::duration_cast< std::chrono::milliseconds >( duration).count()
+              << " ms, cpu " << ( 1000 * cpu / CLOCKS_PER_SEC) << " ms" << std::endl;
+}
+
+void run( allocator_type & salloc) {
+    measure( "  sleep ", [&salloc](){
+        std::vector< boost::fibers::fiber > fibers;
+        fibers.reserve( fibers_count);
+        for ( std::size_t i = 0; i < fibers_count; ++i) {
+            fibers.emplace_back( std::allocator_arg, salloc, sleeper, static_cast< std::uint32_t >( i) );
+        }
+        for ( boost::fibers::fiber & f : fibers) {
+            f.join();
+        }
+    });
+    measure( "  cancel", [&salloc](){
+        std::size_t pairs = fibers_count / 2;
+        std::vector< std::unique_ptr< channel_type > > channels;
+        std::vector< boost::fibers::fiber > fibers;
+        channels.reserve( 2 * pairs);
+        fibers.reserve( 2 * pairs);
+        for ( std::size_t i = 0; i < pairs; ++i) {
+            channels.emplace_back( new channel_type{ 2 });
+            channels.emplace_back( new channel_type{ 2 });
+            channel_type & a = * channels[2 * i];
+            channel_type & b = * channels[2 * i + 1];
+            fibers.emplace_back( std::allocator_arg, salloc, ping, std::ref( a), std::ref( b) );
+            fibers.emplace_back( std::allocator_arg, salloc, pong, std::ref( b), std::ref( a) );
+        }
+        for ( boost::fibers::fiber & f : fibers) {
+            f.join();
+        }
+    });
+}
+
+int main( int argc, char * argv[]) {
+    try {
+        if ( 1 < argc) {
+            fibers_count = std::strtoul( argv[1], nullptr, 10);
+        }
+        // Windows 10 and FreeBSD require a fiber stack of 8kb
+        // otherwise the stack gets exhausted
+        // stack requirements must be checked for other OS too
+#if BOOST_OS_WINDOWS || BOOST_OS_BSD
+        allocator_type salloc{ 2*allocator_type::traits_type::page_size() };
+#else
+        allocator_type salloc{ allocator_type::traits_type::page_size() };
+#endif
+        std::cout << fibers_count << " fibers" << std::endl;
+        std::cout << "ordered set:" << std::endl;
+        boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::ordered_set);
+        run( salloc);
+        std::cout << "timer wheel:" << std::endl;
+        boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::timer_wheel);
+        run( salloc);
+        return EXIT_SUCCESS;
+    } catch ( std::exception const& e) {
+        std::cerr << "exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unhandled exception" << std::endl;
+    }
+	return EXIT_FAILURE;
+}
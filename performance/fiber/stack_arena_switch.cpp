@@ -0,0 +1,174 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// context switch cost of many fibers for fixedsize_stack,
+// protected_fixedsize_stack and arena_fixedsize_stack: each fiber touches
+// its stack and yields, thus every switch lands on another stack;
+// dTLB load misses are counted by perf_event_open() (Linux only)
+// usage: stack_arena_switch [fibers [rounds]]
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+#include <boost/predef.h>
+
+#if BOOST_OS_LINUX
+extern "C" {
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+#endif
+
+using clock_type = std::chrono::steady_clock;
+
+// counts dTLB load misses of the calling thread
+class tlb_counter {
+private:
+    int     fd_{ -1 };
+
+public:
+    tlb_counter() {
+#if BOOST_OS_LINUX
+        perf_event_attr attr;
+        std::memset( & attr, 0, sizeof( attr) );
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.size = sizeof( attr);
+        attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                      ( PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast< int >( ::syscall( SYS_perf_event_open, & attr, 0, -1, -1, 0) );
+#endif
+    }
+
+    ~tlb_counter() {
+#if BOOST_OS_LINUX
+        if ( -1 != fd_) {
+            ::close( fd_);
+        }
+#endif
+    }
+
+    tlb_counter( tlb_counter const&) = delete;
+    tlb_counter & operator=( tlb_counter const&) = delete;
+
+    bool valid() const noexcept {
+        return -1 != fd_;
+    }
+
+    void start() noexcept {
+#if BOOST_OS_LINUX
+        if ( valid() ) {
+            ::ioctl( fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl( fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    std::uint64_t stop() noexcept {
+        std::uint64_t count = 0;
+#if BOOST_OS_LINUX
+        if ( valid() ) {
+            ::ioctl( fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if ( sizeof( count) != ::read( fd_, & count, sizeof( count) ) ) {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+};
+
+void touch_and_yield( std::size_t rounds) {
+    // a cacheline of the stack touched per switch
+    volatile char buffer[256];
+    for ( std::size_t i = 0; i < rounds; ++i) {
+        buffer[i % sizeof( buffer)] = static_cast< char >( i);
+        boost::this_fiber::yield();
+    }
+}
+
+template< typename Allocator >
+void run( std::size_t fiber_count, std::size_t rounds, Allocator salloc, char const* name) {
+    std::vector< boost::fibers::fiber > fibers;
+    fibers.reserve( fiber_count);
+    for ( std::size_t i = 0; i < fiber_count; ++i) {
+        fibers.emplace_back( std::allocator_arg, salloc, touch_and_yield, rounds);
+    }
+    tlb_counter tlb;
+    // first switch to each fiber (faults in the stacks) is not measured
+    boost::this_fiber::yield();
+    tlb.start();
+    clock_type::time_point start{ clock_type::now() };
+    for ( auto & f : fibers) {
+        f.join();
+    }
+    clock_type::duration duration = clock_type::now() - start;
+    std::uint64_t misses = tlb.stop();
+    const std::uint64_t switches = static_cast< std::uint64_t >( fiber_count) * rounds;
+    std::cout << std::left << std::setw( 40) << name
+              << std::right << std::setw( 10)
+              << std::chrono::duration_cast< std::chrono::nanoseconds >( duration).count() / switches << " ns";
+    if ( tlb.valid() ) {
+        std::cout << std::setw( 12) << std::fixed << std::setprecision( 3)
+                  << static_cast< double >( misses) / switches << " dTLB misses/switch";
+    } else {
+        std::cout << std::setw( 12) << "n/a" << " dTLB misses/switch";
+    }
+    std::cout << std::endl;
+}
+
+int main( int argc, char * argv[]) {
+    try {
+        std::size_t fiber_count = 10000;
+        std::size_t rounds = 100;
+        if ( 1 < argc) {
+            fiber_count = std::stoul( argv[1]);
+        }
+        if ( 2 < argc) {
+            rounds = std::stoul( argv[2]);
+        }
+        const std::size_t page_size = boost::context::stack_traits::page_size();
+        const std::size_t stack_size = 16 * page_size;
+        std::cout << "fibers: " << fiber_count << ", rounds: " << rounds
+                  << ", stack size: " << stack_size << std::endl;
+        run( fiber_count, rounds, boost::fibers::fixedsize_stack{ stack_size },
+             "fixedsize_stack");
+        run( fiber_count, rounds, boost::fibers::protected_fixedsize_stack{ stack_size },
+             "protected_fixedsize_stack");
+        run( fiber_count, rounds,
+             boost::fibers::arena_fixedsize_stack{ stack_size, 0, 256, boost::fibers::huge_page_policy::none },
+             "arena_fixedsize_stack (base pages)");
+        run( fiber_count, rounds,
+             boost::fibers::arena_fixedsize_stack{ stack_size, 0, 256, boost::fibers::huge_page_policy::transparent },
+             "arena_fixedsize_stack (THP)");
+        run( fiber_count, rounds,
+             boost::fibers::arena_fixedsize_stack{ stack_size, page_size, 256, boost::fibers::huge_page_policy::none },
+             "arena_fixedsize_stack (guard)");
+        run( fiber_count, rounds,
+             boost::fibers::arena_fixedsize_stack{ stack_size, 0, 256, boost::fibers::huge_page_policy::hugetlb },
+             "arena_fixedsize_stack (hugetlb)");
+        return EXIT_SUCCESS;
+    } catch ( std::exception const& e) {
+        std::cerr << "exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unhandled exception" << std::endl;
+    }
+	return EXIT_FAILURE;
+}
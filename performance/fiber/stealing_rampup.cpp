@@ -0,0 +1,128 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// measures how fast parallelism ramps up from idle:
+// all schedulers of a work-stealing domain are parked (suspend = true)
+// when a burst of CPU-bound fibers is spawned on one thread
+//  - ramp-up: time until the last scheduler runs a fiber of the burst
+//  - duration: time until the burst is complete
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+
+#include "barrier.hpp"
+
+using clock_type = std::chrono::steady_clock;
+using duration_type = clock_type::duration;
+using time_point_type = clock_type::time_point;
+using lock_type = std::unique_lock< std::mutex >;
+
+static bool done = false;
+static std::mutex mtx{};
+static boost::fibers::condition_variable_any cnd{};
+
+static std::size_t rounds{ 20 };
+static std::size_t fibers_per_thread{ 8 };
+static std::chrono::microseconds work{ 500 };
+
+struct burst {
+    std::atomic< std::uint32_t >    running{ 0 };
+    std::atomic< std::size_t >      completed{ 0 };
+    std::atomic< std::int64_t >     rampup{ 0 };
+    time_point_type                 start{};
+};
+
+thread_local std::size_t last_round = 0;
+
+void worker( burst * b, std::size_t round, std::uint32_t thread_count) {
+    if ( round != last_round) {
+        // first fiber of this burst on this thread
+        last_round = round;
+        if ( thread_count == ++b->running) {
+            b->rampup = ( clock_type::now() - b->start).count();
+        }
+    }
+    // CPU-bound, never yields
+    const time_point_type end{ clock_type::now() + work };
+    while ( clock_type::now() < end);
+    ++b->completed;
+}
+
+void thread( std::shared_ptr< boost::fibers::algo::stealing_domain > domain, barrier * b) {
+    boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain, true);
+    b->wait();
+    lock_type lk( mtx);
+    cnd.wait( lk, [](){ return done; });
+}
+
+int main() {
+    try {
+        // count of logical cpus
+        std::uint32_t thread_count = std::thread::hardware_concurrency();
+        auto domain = std::make_shared< boost::fibers::algo::stealing_domain >( thread_count);
+        // main-thread registers itself at work-stealing scheduler
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain, true);
+        barrier b{ thread_count };
+        std::vector< std::thread > threads;
+        for ( std::uint32_t i = 1 /* count main-thread */; i < thread_count; ++i) {
+            threads.emplace_back( thread, domain, & b);
+        }
+        b.wait();
+        const std::size_t count = thread_count * fibers_per_thread;
+        duration_type rampup{ 0 }, duration{ 0 };
+        std::size_t ramped = 0;
+        for ( std::size_t round = 1; round <= rounds; ++round) {
+            // let the other schedulers park
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10) );
+            burst bu{};
+            bu.start = clock_type::now();
+            for ( std::size_t i = 0; i < count; ++i) {
+                boost::fibers::fiber{ worker, & bu, round, thread_count }.detach();
+            }
+            while ( count != bu.completed) {
+                boost::this_fiber::yield();
+            }
+            duration += clock_type::now() - bu.start;
+            if ( thread_count == bu.running) {
+                rampup += duration_type{ bu.rampup.load() };
+                ++ramped;
+            }
+        }
+        lock_type lk( mtx);
+        done = true;
+        lk.unlock();
+        cnd.notify_all();
+        for ( std::thread & t : threads) {
+            t.join();
+        }
+        std::cout << "threads: " << thread_count << ", fibers per burst: " << count << std::endl;
+        if ( 0 != ramped) {
+            std::cout << "ramp-up: " << std::chrono::duration_cast< std::chrono::microseconds >( rampup).count() / ramped
+                      << " us (all threads busy in " << ramped << " of " << rounds << " bursts)" << std::endl;
+        } else {
+            std::cout << "ramp-up: never all threads busy" << std::endl;
+        }
+        std::cout << "duration: " << std::chrono::duration_cast< std::chrono::microseconds >( duration).count() / rounds
+                  << " us per burst (ideal: " << work.count() * fibers_per_thread << " us)" << std::endl;
+        return EXIT_SUCCESS;
+    } catch ( std::exception const& e) {
+        std::cerr << "exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unhandled exception" << std::endl;
+    }
+	return EXIT_FAILURE;
+}
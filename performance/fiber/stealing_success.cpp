@@ -0,0 +1,130 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// success rate of steal attempts of work_stealing running skynet
+// (based on https://github.com/atemerev/skynet from Alexander Temerev)
+// a steal fails if the victim's deque is empty or if another thief won the race
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+#include <boost/predef.h>
+
+#include "barrier.hpp"
+
+using clock_type = std::chrono::steady_clock;
+using duration_type = clock_type::duration;
+using time_point_type = clock_type::time_point;
+using channel_type = boost::fibers::buffered_channel< std::uint64_t >;
+using allocator_type = boost::fibers::fixedsize_stack;
+using lock_type = std::unique_lock< std::mutex >;
+
+static bool done = false;
+static std::mutex mtx{};
+static boost::fibers::condition_variable_any cnd{};
+static std::uint64_t steal_attempts{ 0 };
+static std::uint64_t steal_successes{ 0 };
+
+void collect() {
+    boost::fibers::scheduler_statistics stats = boost::fibers::get_statistics();
+    lock_type lk( mtx);
+    steal_attempts += stats.steal_attempts;
+    steal_successes += stats.steal_successes;
+}
+
+// microbenchmark
+void skynet( allocator_type & salloc, channel_type & c, std::size_t num, std::size_t size, std::size_t div) {
+    if ( 1 == size) {
+        c.push( num);
+    } else {
+        channel_type rc{ 16 };
+        for ( std::size_t i = 0; i < div; ++i) {
+            auto sub_num = num + i * size / div;
+            boost::fibers::fiber{ boost::fibers::launch::dispatch,
+                              std::allocator_arg, salloc,
+                              skynet,
+                              std::ref( salloc), std::ref( rc), sub_num, size / div, div }.detach();
+        }
+        std::uint64_t sum{ 0 };
+        for ( std::size_t i = 0; i < div; ++i) {
+            sum += rc.value_pop();
+        }
+        c.push( sum);
+    }
+}
+
+void thread( std::shared_ptr< boost::fibers::algo::stealing_domain > domain, barrier * b) {
+    // thread registers itself at work-stealing scheduler
+    boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain);
+    b->wait();
+    lock_type lk( mtx);
+    cnd.wait( lk, [](){ return done; });
+    lk.unlock();
+    collect();
+}
+
+int main() {
+    try {
+        // count of logical cpus
+        std::uint32_t thread_count = std::thread::hardware_concurrency();
+        auto domain = std::make_shared< boost::fibers::algo::stealing_domain >( thread_count);
+        // main-thread registers itself at work-stealing scheduler
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain);
+        barrier b{ thread_count };
+        std::size_t size{ 1000000 };
+        std::size_t div{ 10 };
+        // Windows 10 and FreeBSD require a fiber stack of 8kb
+        // otherwise the stack gets exhausted
+        // stack requirements must be checked for other OS too
+#if BOOST_OS_WINDOWS || BOOST_OS_BSD
+        allocator_type salloc{ 2*allocator_type::traits_type::page_size() };
+#else
+        allocator_type salloc{ allocator_type::traits_type::page_size() };
+#endif
+        std::uint64_t result{ 0 };
+        channel_type rc{ 2 };
+        std::vector< std::thread > threads;
+        for ( std::uint32_t i = 1 /* count main-thread */; i < thread_count; ++i) {
+            // spawn thread
+            threads.emplace_back( thread, domain, & b);
+        }
+        b.wait();
+        time_point_type start{ clock_type::now() };
+        skynet( salloc, rc, 0, size, div);
+        result = rc.value_pop();
+        if ( 499999500000 != result) {
+            throw std::runtime_error("invalid result");
+        }
+        auto duration = clock_type::now() - start;
+        lock_type lk( mtx);
+        done = true;
+        lk.unlock();
+        cnd.notify_all();
+        for ( std::thread & t : threads) {
+            t.join();
+        }
+        collect();
+        std::cout << "duration: " << duration.count() / 1000000 << " ms" << std::endl;
+        std::cout << "steal attempts: " << steal_attempts << ", successes: " << steal_successes;
+        if ( 0 != steal_attempts) {
+            std::cout << " (" << ( 100. * steal_successes) / steal_attempts << "%)";
+        }
+        std::cout << std::endl;
+        return EXIT_SUCCESS;
+    } catch ( std::exception const& e) {
+        std::cerr << "exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "unhandled exception" << std::endl;
+    }
+	return EXIT_FAILURE;
+}
@@ -7,12 +7,16 @@
 
 #include "boost/fiber/algo/numa/work_stealing.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <map>
 #include <random>
+#include <set>
 
 #include <boost/assert.hpp>
 #include <boost/context/detail/prefetch.hpp>
 
+#include "boost/fiber/scheduler.hpp"
 #include "boost/fiber/type.hpp"
 
 #ifdef BOOST_HAS_ABI_HEADERS
@@ -24,153 +28,283 @@ namespace fibers {
 namespace algo {
 namespace numa {
 
-std::vector< intrusive_ptr< work_stealing > > work_stealing::schedulers_{};
-
-std::vector< std::uint32_t > get_local_cpus( std::uint32_t node_id, std::vector< boost::fibers::numa::node > const& topo) {
+// logical cpus of the local NUMA node (except cpu_id) grouped by the
+// hardware resources shared with cpu_id: hardware threads of the same
+// core, L2 cache, L3 cache, remaining logical cpus of the node
+std::vector< std::vector< std::uint32_t > > get_local_tiers( std::uint32_t cpu_id, std::uint32_t node_id, std::vector< boost::fibers::numa::node > const& topo) {
+    std::vector< std::vector< std::uint32_t > > local_tiers;
     for ( auto & node : topo) {
-        if ( node_id == node.id) {
-            // store IDs of logical cpus that belong to this local NUMA node
-            return std::vector< std::uint32_t >{ node.logical_cpus.begin(), node.logical_cpus.end() };
+        if ( node_id != node.id) {
+            continue;
+        }
+        // each logical cpu is assigned to the nearest tier
+        std::set< std::uint32_t > assigned{ cpu_id };
+        auto add_tier = [&node,&assigned,&local_tiers]( std::set< std::uint32_t > const& cpus) {
+            std::vector< std::uint32_t > tier;
+            for ( std::uint32_t id : cpus) {
+                if ( 0 != node.logical_cpus.count( id) && assigned.insert( id).second) {
+                    tier.push_back( id);
+                }
+            }
+            if ( ! tier.empty() ) {
+                local_tiers.push_back( std::move( tier) );
+            }
+        };
+        auto i = node.siblings.find( cpu_id);
+        if ( node.siblings.end() != i) {
+            add_tier( i->second.core);
+            add_tier( i->second.l2_cache);
+            add_tier( i->second.l3_cache);
         }
+        add_tier( node.logical_cpus);
     }
-    return std::vector< std::uint32_t >{};
+    return local_tiers;
 }
 
-std::vector< std::uint32_t > get_remote_cpus( std::uint32_t node_id, std::vector< boost::fibers::numa::node > const& topo) {
-    std::vector< std::uint32_t > remote_cpus;
+// logical cpus of the remote NUMA nodes grouped by the NUMA distance
+// from node_id, nearest nodes first; if the distances are unknown,
+// all remote cpus form one tier
+std::vector< std::vector< std::uint32_t > > get_remote_tiers( std::uint32_t node_id, std::vector< boost::fibers::numa::node > const& topo) {
+    std::vector< std::uint32_t > const* distance = nullptr;
     for ( auto & node : topo) {
-        if ( node_id != node.id) {
-            // store IDs of logical cpus that belong to a remote NUMA node
-            // no ordering regarding to the NUMA distance
-            remote_cpus.insert( remote_cpus.end(), node.logical_cpus.begin(), node.logical_cpus.end() );
+        if ( node_id == node.id) {
+            distance = & node.distance;
         }
     }
-    return remote_cpus;
+    std::map< std::uint32_t, std::vector< std::uint32_t > > tiers;
+    for ( auto & node : topo) {
+        if ( node_id == node.id) {
+            continue;
+        }
+        std::uint32_t d = 0;
+        // the index in node::distance is the ID of the NUMA node
+        if ( nullptr != distance && node.id < distance->size() ) {
+            d = ( * distance)[node.id];
+        }
+        std::vector< std::uint32_t > & cpus = tiers[d];
+        cpus.insert( cpus.end(), node.logical_cpus.begin(), node.logical_cpus.end() );
+    }
+    std::vector< std::vector< std::uint32_t > > remote_tiers;
+    for ( auto & tier : tiers) {
+        if ( ! tier.second.empty() ) {
+            remote_tiers.push_back( std::move( tier.second) );
+        }
+    }
+    return remote_tiers;
 }
 
-void
-work_stealing::init_( std::vector< boost::fibers::numa::node > const& topo,
-                      std::vector< intrusive_ptr< work_stealing > > & schedulers) {
+namespace {
+
+std::shared_ptr< stealing_domain > default_domain( std::vector< boost::fibers::numa::node > const& topo) {
+    // initialized by the first call
+    static std::shared_ptr< stealing_domain > domain{
+        std::make_shared< stealing_domain >( work_stealing::domain_size( topo) ) };
+    return domain;
+}
+
+}
+
+std::uint32_t
+work_stealing::domain_size( std::vector< boost::fibers::numa::node > const& topo) noexcept {
     std::uint32_t max_cpu_id = 0;
     for ( auto & node : topo) {
-        max_cpu_id = (std::max)( max_cpu_id, * node.logical_cpus.rbegin() );
+        if ( ! node.logical_cpus.empty() ) {
+            max_cpu_id = (std::max)( max_cpu_id, * node.logical_cpus.rbegin() );
+        }
     }
-    // resize array of schedulers to max. CPU ID, initilized with nullptr
-    // CPU ID acts as the index in the scheduler array
-    // if a logical cpus is offline, schedulers_ will contain a nullptr
+    // CPU ID acts as the index in the domain
+    // if a logical cpus is offline, its slot is never used
     // logical cpus index starts at `0`
-    std::vector< intrusive_ptr< work_stealing > >{ max_cpu_id + 1, nullptr }.swap( schedulers);
+    return max_cpu_id + 1;
+}
+
+work_stealing::work_stealing(
+    std::uint32_t cpu_id,
+    std::uint32_t node_id,
+    std::vector< boost::fibers::numa::node > const& topo,
+    bool suspend) :
+        work_stealing{ cpu_id, node_id, topo, default_domain( topo), suspend } {
+}
+
+work_stealing::work_stealing(
+    std::uint32_t cpu_id,
+    std::uint32_t node_id,
+    std::vector< boost::fibers::numa::node > const& topo,
+    std::shared_ptr< stealing_domain > domain,
+    bool suspend) :
+        work_stealing{ cpu_id, node_id, topo, std::move( domain), memory_migration{}, suspend } {
 }
 
 work_stealing::work_stealing(
     std::uint32_t cpu_id,
     std::uint32_t node_id,
     std::vector< boost::fibers::numa::node > const& topo,
+    std::shared_ptr< stealing_domain > domain,
+    memory_migration const& migration,
     bool suspend) :
+        domain_{ std::move( domain) },
         cpu_id_{ cpu_id },
-        local_cpus_{ get_local_cpus( node_id, topo) },
-        remote_cpus_{ get_remote_cpus( node_id, topo) },
+        node_id_{ node_id },
+        local_tiers_{ get_local_tiers( cpu_id, node_id, topo) },
+        remote_tiers_{ get_remote_tiers( node_id, topo) },
+        rqueue_( domain_->queue( cpu_id_) ),
+        migration_( migration),
         suspend_{ suspend } {
+    BOOST_ASSERT( cpu_id_ < domain_->size() );
+    BOOST_ASSERT( 0 < migration_.threshold);
     // pin current thread to logical cpu
     boost::fibers::numa::pin_thread( cpu_id_);
-    // initialize the array of schedulers
-    static std::once_flag flag;
-    std::call_once( flag, & work_stealing::init_, topo, std::ref( schedulers_) );
-    // register pointer of this scheduler
-    schedulers_[cpu_id_] = this;
+    // stacks allocated by numa::pooled_fixedsize_stack are bound to node_id
+    boost::fibers::numa::set_current_node( node_id);
+}
+
+void
+work_stealing::track_node_( context * ctx) noexcept {
+    void * top = ctx->get_stack_top();
+    if ( nullptr == top) {
+        return;
+    }
+    if ( boost::fibers::numa::unknown_node == ctx->numa_node) {
+        // launched by a thread not bound to a NUMA node (the first pick
+        // might be a thief's), the node of the context's page is queried
+        ctx->numa_node = boost::fibers::numa::memory_node( ctx);
+        if ( boost::fibers::numa::unknown_node == ctx->numa_node) {
+            // placement not supported
+            ctx->numa_node = node_id_;
+            return;
+        }
+    }
+    if ( node_id_ == ctx->numa_node) {
+        ctx->numa_remote_picks = 0;
+        return;
+    }
+    if ( ++ctx->numa_remote_picks < migration_.threshold) {
+        return;
+    }
+    // the pages below the context (the frames used most recently)
+    // and the context itself are moved
+    char * bottom = static_cast< char * >( ctx->get_stack_bottom() );
+    if ( migration_.stack_bytes < static_cast< std::size_t >( static_cast< char * >( top) - bottom) ) {
+        bottom = static_cast< char * >( top) - migration_.stack_bytes;
+    }
+    const std::size_t moved =
+        boost::fibers::numa::migrate_memory( bottom, static_cast< char * >( top) - bottom, node_id_);
+    if ( 0 != moved) {
+        detail::scheduler_counters & counters = ctx->get_scheduler()->get_counters();
+        counters.migrated_pages.increment( moved);
+        counters.stack_migrations.increment();
+    }
+    // the fiber becomes local only if its context is located on this node
+    // now; otherwise (migration not permitted) it is retried after
+    // threshold further picks
+    if ( node_id_ == boost::fibers::numa::memory_node( ctx) ) {
+        ctx->numa_node = node_id_;
+    }
+    ctx->numa_remote_picks = 0;
 }
 
 void
 work_stealing::awakened( context * ctx) noexcept {
-    if ( ! ctx->is_context( type::pinned_context) ) {
-        ctx->detach();
+    if ( ctx->is_context( type::pinned_context) ) {
+        // kept out of the deque, otherwise a pinned context at
+        // the top of the deque blocks all thieves
+        if ( pinned_.empty() ) {
+            pinned_wait_ = stealing_domain::pinned_wait( rqueue_.size() );
+        }
+        ctx->ready_link( pinned_);
+        return;
     }
-    rqueue_.push( ctx);
+    detail::scheduler_counters & counters = ctx->get_scheduler()->get_counters();
+    ctx->detach();
+    // the length is returned by push(), size() would lock the queue again
+    counters.ready_queue_high_water_mark.update_max( rqueue_.push( ctx) );
 }
 
 context *
 work_stealing::pick_next() noexcept {
-    context * victim = rqueue_.pop();
+    context * victim = nullptr;
+    if ( pinned_.empty() ) {
+        victim = rqueue_.pop();
+    } else if ( 0 != pinned_wait_) {
+        // a pending pinned context waits for one round of the local deque
+        victim = rqueue_.pop();
+        --pinned_wait_;
+    }
     if ( nullptr != victim) {
         boost::context::detail::prefetch_range( victim, sizeof( victim) );
-        if ( ! victim->is_context( type::pinned_context) ) {
-            context::active()->attach( victim);
-        }
+        context::active()->attach( victim);
+    } else if ( ! pinned_.empty() ) {
+        victim = & pinned_.front();
+        pinned_.pop_front();
+        pinned_wait_ = stealing_domain::pinned_wait( rqueue_.size() );
+    } else if ( nullptr != ( victim = domain_->overflow().steal() ) ) {
+        // fibers spilled by a bounded ready-queue
+        context::active()->attach( victim);
     } else {
-        std::uint32_t cpu_id = 0;
-        std::size_t count = 0, size = local_cpus_.size();
+        scheduler * sched = context::active()->get_scheduler();
         static thread_local std::minstd_rand generator{ std::random_device{}() };
-        std::uniform_int_distribution< std::uint32_t > local_distribution{
-            0, static_cast< std::uint32_t >( local_cpus_.size() - 1) };
-        std::uniform_int_distribution< std::uint32_t > remote_distribution{
-            0, static_cast< std::uint32_t >( remote_cpus_.size() - 1) };
-        do {
-            do {
-                ++count;
-                // random selection of one logical cpu
-                // that belongs to the local NUMA node
-                cpu_id = local_cpus_[local_distribution( generator)];
-                // prevent stealing from own scheduler
-            } while ( cpu_id == cpu_id_);
-            // steal context from other scheduler
-            // schedulers_[cpu_id] should never contain a nullptr
-            BOOST_ASSERT( nullptr != schedulers_[cpu_id]);
-            victim = schedulers_[cpu_id]->steal();
-        } while ( nullptr == victim && count < size);
+        // steal from the logical cpus of the local NUMA node, those
+        // sharing the core or a cache with this logical cpu first
+        for ( std::size_t tier = 0; nullptr == victim && tier < local_tiers_.size(); ++tier) {
+            std::vector< std::uint32_t > const& cpus = local_tiers_[tier];
+            std::uniform_int_distribution< std::uint32_t > distribution{
+                0, static_cast< std::uint32_t >( cpus.size() - 1) };
+            for ( std::size_t count = 0; nullptr == victim && count < cpus.size(); ++count) {
+                const std::uint32_t cpu_id = cpus[distribution( generator)];
+                BOOST_ASSERT( cpu_id != cpu_id_);
+                // steal up to half of the contexts from other scheduler,
+                // all but the returned one are moved to the local queue
+                victim = domain_->queue( cpu_id).steal_half( rqueue_);
+                sched->get_counters().steal_attempts.increment();
+            }
+        }
+        // steal from the remote NUMA nodes, nearest nodes first;
+        // the number of attempts is halved with each tier
+        bool remote = false;
+        for ( std::size_t tier = 0; nullptr == victim && tier < remote_tiers_.size(); ++tier) {
+            std::vector< std::uint32_t > const& cpus = remote_tiers_[tier];
+            std::uniform_int_distribution< std::uint32_t > distribution{
+                0, static_cast< std::uint32_t >( cpus.size() - 1) };
+            const std::size_t budget = (std::max)( cpus.size() >> tier, std::size_t( 1) );
+            for ( std::size_t count = 0; nullptr == victim && count < budget; ++count) {
+                const std::uint32_t cpu_id = cpus[distribution( generator)];
+                // remote cpu ID should never be equal to local cpu ID
+                BOOST_ASSERT( cpu_id != cpu_id_);
+                victim = domain_->queue( cpu_id).steal_half( rqueue_);
+                sched->get_counters().steal_attempts.increment();
+            }
+            remote = nullptr != victim;
+        }
         if ( nullptr != victim) {
+            sched->get_counters().steal_successes.increment();
+            if ( remote) {
+                sched->get_counters().remote_steal_successes.increment();
+            }
             boost::context::detail::prefetch_range( victim, sizeof( victim) );
             BOOST_ASSERT( ! victim->is_context( type::pinned_context) );
             context::active()->attach( victim);
-        } else if ( ! remote_cpus_.empty() ) {
-            cpu_id = 0;
-            count = 0;
-            size = remote_cpus_.size();
-            do {
-                ++count;
-                // random selection of one logical cpu
-                // that belongs to a remote NUMA node
-                cpu_id = remote_cpus_[remote_distribution( generator)];
-                // remote cpu ID should never be equal to local cpu ID
-                BOOST_ASSERT( cpu_id != cpu_id_);
-                // schedulers_[cpu_id] should never contain a nullptr
-                BOOST_ASSERT( nullptr != schedulers_[cpu_id]);
-                // steal context from other scheduler
-                victim = schedulers_[cpu_id]->steal();
-            } while ( nullptr == victim && count < size);
-            if ( nullptr != victim) {
-                boost::context::detail::prefetch_range( victim, sizeof( victim) );
-                BOOST_ASSERT( ! victim->is_context( type::pinned_context) );
-                // move memory from remote NUMA-node to
-                // memory of local NUMA-node
-                context::active()->attach( victim);
-            }
+            sched->trace( trace_event::steal, victim);
         }
     }
+    if ( migration_.enabled && nullptr != victim) {
+        track_node_( victim);
+    }
     return victim;
 }
 
 void
 work_stealing::suspend_until( std::chrono::steady_clock::time_point const& time_point) noexcept {
+    // release memory of a ready queue grown by a spike of ready fibers
+    rqueue_.shrink();
     if ( suspend_) {
-        if ( (std::chrono::steady_clock::time_point::max)() == time_point) {
-            std::unique_lock< std::mutex > lk{ mtx_ };
-            cnd_.wait( lk, [this](){ return flag_; });
-            flag_ = false;
-        } else {
-            std::unique_lock< std::mutex > lk{ mtx_ };
-            cnd_.wait_until( lk, time_point, [this](){ return flag_; });
-            flag_ = false;
-        }
+        parker_.park_until( time_point);
     }
 }
 
 void
 work_stealing::notify() noexcept {
     if ( suspend_) {
-        std::unique_lock< std::mutex > lk{ mtx_ };
-        flag_ = true;
-        lk.unlock();
-        cnd_.notify_all();
+        parker_.unpark();
     }
 }
 
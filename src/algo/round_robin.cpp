@@ -23,6 +23,7 @@ round_robin::awakened( context * ctx) noexcept {
     BOOST_ASSERT( ! ctx->ready_is_linked() );
     BOOST_ASSERT( ctx->is_resumable() );
     ctx->ready_link( rqueue_);
+    ctx->get_scheduler()->get_counters().ready_queue_high_water_mark.update_max( ++rqueue_size_);
 }
 
 context *
@@ -31,6 +32,7 @@ round_robin::pick_next() noexcept {
     if ( ! rqueue_.empty() ) {
         victim = & rqueue_.front();
         rqueue_.pop_front();
+        --rqueue_size_;
         boost::context::detail::prefetch_range( victim, sizeof( victim) );
         BOOST_ASSERT( nullptr != victim);
         BOOST_ASSERT( ! victim->ready_is_linked() );
@@ -46,23 +48,12 @@ round_robin::has_ready_fibers() const noexcept {
 
 void
 round_robin::suspend_until( std::chrono::steady_clock::time_point const& time_point) noexcept {
-    if ( (std::chrono::steady_clock::time_point::max)() == time_point) {
-        std::unique_lock< std::mutex > lk{ mtx_ };
-        cnd_.wait( lk, [&](){ return flag_; });
-        flag_ = false;
-    } else {
-        std::unique_lock< std::mutex > lk{ mtx_ };
-        cnd_.wait_until( lk, time_point, [&](){ return flag_; });
-        flag_ = false;
-    }
+    parker_.park_until( time_point);
 }
 
 void
 round_robin::notify() noexcept {
-    std::unique_lock< std::mutex > lk{ mtx_ };
-    flag_ = true;
-    lk.unlock();
-    cnd_.notify_all();
+    parker_.unpark();
 }
 
 }}}
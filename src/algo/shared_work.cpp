@@ -28,11 +28,13 @@ shared_work::awakened( context * ctx) noexcept {
         >*/
         lqueue_.push_back( * ctx);
     } else {
+        detail::scheduler_counters & counters = ctx->get_scheduler()->get_counters();
         ctx->detach();
         std::unique_lock< std::mutex > lk{ rqueue_mtx_ }; /*<
                 worker fiber, enqueue on shared queue
             >*/
         rqueue_.push_back( ctx);
+        counters.ready_queue_high_water_mark.update_max( rqueue_.size() );
     }
 }
 //]
@@ -69,25 +71,14 @@ shared_work::pick_next() noexcept {
 void
 shared_work::suspend_until( std::chrono::steady_clock::time_point const& time_point) noexcept {
     if ( suspend_) {
-        if ( (std::chrono::steady_clock::time_point::max)() == time_point) {
-            std::unique_lock< std::mutex > lk{ mtx_ };
-            cnd_.wait( lk, [this](){ return flag_; });
-            flag_ = false;
-        } else {
-            std::unique_lock< std::mutex > lk{ mtx_ };
-            cnd_.wait_until( lk, time_point, [this](){ return flag_; });
-            flag_ = false;
-        }
+        parker_.park_until( time_point);
     }
 }
 
 void
 shared_work::notify() noexcept {
     if ( suspend_) {
-        std::unique_lock< std::mutex > lk{ mtx_ };
-        flag_ = true;
-        lk.unlock();
-        cnd_.notify_all();
+        parker_.unpark();
     }
 }
 
@@ -12,6 +12,7 @@
 #include <boost/assert.hpp>
 #include <boost/context/detail/prefetch.hpp>
 
+#include "boost/fiber/scheduler.hpp"
 #include "boost/fiber/type.hpp"
 
 #ifdef BOOST_HAS_ABI_HEADERS
@@ -22,64 +23,144 @@ namespace boost {
 namespace fibers {
 namespace algo {
 
-std::atomic< std::uint32_t > work_stealing::counter_{ 0 };
-std::vector< intrusive_ptr< work_stealing > > work_stealing::schedulers_{};
+namespace {
+
+std::shared_ptr< stealing_domain > default_domain( std::uint32_t thread_count) {
+    // initialized by the first call
+    static std::shared_ptr< stealing_domain > domain{
+        std::make_shared< stealing_domain >( thread_count) };
+    return domain;
+}
 
-void
-work_stealing::init_( std::uint32_t thread_count,
-                      std::vector< intrusive_ptr< work_stealing > > & schedulers) {
-    // resize array of schedulers to thread_count, initilized with nullptr
-    std::vector< intrusive_ptr< work_stealing > >{ thread_count, nullptr }.swap( schedulers);
 }
 
 work_stealing::work_stealing( std::uint32_t thread_count, bool suspend) :
-        id_{ counter_++ },
-        thread_count_{ thread_count },
+        work_stealing{ default_domain( thread_count), suspend } {
+}
+
+work_stealing::work_stealing( std::shared_ptr< stealing_domain > domain, bool suspend) :
+        domain_{ std::move( domain) },
+        id_{ domain_->acquire_slot( suspend) },
+        rqueue_( domain_->queue( id_) ),
         suspend_{ suspend } {
-    // initialize the array of schedulers
-    static std::once_flag flag;
-    std::call_once( flag, & work_stealing::init_, thread_count_, std::ref( schedulers_) );
-    // register pointer of this scheduler
-    schedulers_[id_] = this;
+}
+
+work_stealing::~work_stealing() {
+    context * ctx = nullptr;
+    while ( nullptr != ( ctx = rqueue_.pop() ) ) {
+        migrate_( ctx);
+    }
+    domain_->release_slot( id_);
+}
+
+void
+work_stealing::migrate_( context * ctx) noexcept {
+    // ctx is already detached
+    domain_->overflow().push( ctx);
+    domain_->notify_idle( id_);
+}
+
+void
+work_stealing::retire() noexcept {
+    if ( retiring_) {
+        return;
+    }
+    // no longer selected as victim
+    domain_->retire_slot( id_);
+    retiring_ = true;
+    context * ctx = nullptr;
+    while ( nullptr != ( ctx = rqueue_.pop() ) ) {
+        migrate_( ctx);
+    }
+    if ( 0 == domain_->live_count() ) {
+        // the last live scheduler is gone, a parked retired
+        // scheduler takes over the overflow queue
+        domain_->notify_idle( id_);
+    }
 }
 
 void
 work_stealing::awakened( context * ctx) noexcept {
-    if ( ! ctx->is_context( type::pinned_context) ) {
-        ctx->detach();
+    if ( ctx->is_context( type::pinned_context) ) {
+        // kept out of the deque, otherwise a pinned context at
+        // the top of the deque blocks all thieves
+        if ( pinned_.empty() ) {
+            pinned_wait_ = stealing_domain::pinned_wait( rqueue_.size() );
+        }
+        ctx->ready_link( pinned_);
+        return;
+    }
+    detail::scheduler_counters & counters = ctx->get_scheduler()->get_counters();
+    ctx->detach();
+    if ( retiring_) {
+        migrate_( ctx);
+        return;
     }
-    rqueue_.push( ctx);
+    // the length is returned by push(), size() would lock the queue again
+    counters.ready_queue_high_water_mark.update_max( rqueue_.push( ctx) );
+    // wake up a parked scheduler if no thief is spinning
+    domain_->notify_idle( id_);
 }
 
 context *
 work_stealing::pick_next() noexcept {
-    context * victim = rqueue_.pop();
+    context * victim = nullptr;
+    if ( pinned_.empty() ) {
+        victim = rqueue_.pop();
+    } else if ( 0 != pinned_wait_) {
+        // a pending pinned context waits for one round of the local deque
+        victim = rqueue_.pop();
+        --pinned_wait_;
+    }
     if ( nullptr != victim) {
         boost::context::detail::prefetch_range( victim, sizeof( victim) );
-        if ( ! victim->is_context( type::pinned_context) ) {
-            context::active()->attach( victim);
+        context::active()->attach( victim);
+    } else if ( ! pinned_.empty() ) {
+        victim = & pinned_.front();
+        pinned_.pop_front();
+        pinned_wait_ = stealing_domain::pinned_wait( rqueue_.size() );
+    } else if ( retiring_) {
+        // no live scheduler is left to run the migrated fibers
+        if ( 0 == domain_->live_count() ) {
+            victim = domain_->overflow().steal();
+            if ( nullptr != victim) {
+                context::active()->attach( victim);
+            }
         }
     } else {
-        std::uint32_t id = 0;
-        std::size_t count = 0, size = schedulers_.size();
-        static thread_local std::minstd_rand generator{ std::random_device{}() };
-        std::uniform_int_distribution< std::uint32_t > distribution{
-            0, static_cast< std::uint32_t >( thread_count_ - 1) };
-        do {
-            do {
-                ++count;
-                // random selection of one logical cpu
-                // that belongs to the local NUMA node
-                id = distribution( generator);
-                // prevent stealing from own scheduler
-            } while ( id == id_);
-            // steal context from other scheduler
-            victim = schedulers_[id]->steal();
-        } while ( nullptr == victim && count < size);
+        throttled_ = false;
+        scheduler * sched = context::active()->get_scheduler();
+        // fibers migrated from retired schedulers
+        victim = domain_->overflow().steal();
+        // only live schedulers are selected as victim
+        const std::uint32_t size = domain_->live_count();
+        if ( nullptr == victim && 1 < size) {
+            if ( domain_->begin_spinning() ) {
+                static thread_local std::minstd_rand generator{ std::random_device{}() };
+                std::uniform_int_distribution< std::uint32_t > distribution{ 0, size - 1 };
+                for ( std::uint32_t count = 0; nullptr == victim && count < size; ++count) {
+                    const std::uint32_t id = domain_->live_slot( distribution( generator) );
+                    // prevent stealing from own scheduler
+                    if ( id == id_) {
+                        continue;
+                    }
+                    // steal up to half of the contexts from other scheduler,
+                    // all but the returned one are moved to the local queue
+                    victim = domain_->queue( id).steal_half( rqueue_);
+                    sched->get_counters().steal_attempts.increment();
+                }
+                domain_->end_spinning( id_, nullptr != victim);
+            } else {
+                // enough thieves are spinning, park
+                throttled_ = true;
+            }
+        }
         if ( nullptr != victim) {
+            sched->get_counters().steal_successes.increment();
             boost::context::detail::prefetch_range( victim, sizeof( victim) );
             BOOST_ASSERT( ! victim->is_context( type::pinned_context) );
             context::active()->attach( victim);
+            sched->trace( trace_event::steal, victim);
         }
     }
     return victim;
@@ -87,26 +168,25 @@ work_stealing::pick_next() noexcept {
 
 void
 work_stealing::suspend_until( std::chrono::steady_clock::time_point const& time_point) noexcept {
+    // release memory of a ready queue grown by a spike of ready fibers
+    rqueue_.shrink();
     if ( suspend_) {
-        if ( (std::chrono::steady_clock::time_point::max)() == time_point) {
-            std::unique_lock< std::mutex > lk{ mtx_ };
-            cnd_.wait( lk, [this](){ return flag_; });
-            flag_ = false;
+        if ( retiring_) {
+            // does not spin while live schedulers have ready fibers
+            domain_->park_retired_until( id_, time_point);
         } else {
-            std::unique_lock< std::mutex > lk{ mtx_ };
-            cnd_.wait_until( lk, time_point, [this](){ return flag_; });
-            flag_ = false;
+            // a throttled scheduler parks without re-checking the queues,
+            // the spinning thieves take care of the ready fibers
+            domain_->park_until( id_, time_point, ! throttled_);
         }
+        throttled_ = false;
     }
 }
 
 void
 work_stealing::notify() noexcept {
     if ( suspend_) {
-        std::unique_lock< std::mutex > lk{ mtx_ };
-        flag_ = true;
-        lk.unlock();
-        cnd_.notify_all();
+        domain_->unpark( id_);
     }
 }
 
@@ -116,8 +116,27 @@ context::reset_active() noexcept {
     context_initializer::active_ = nullptr;
 }
 
+namespace detail {
+
+stack_cache *
+current_stack_cache() noexcept {
+    // do not initialize the thread's scheduler
+    context * active_ctx = context_initializer::active_;
+    if ( nullptr == active_ctx) {
+        return nullptr;
+    }
+    scheduler * sched = active_ctx->get_scheduler();
+    return nullptr != sched ? sched->get_stack_cache() : nullptr;
+}
+
+}
+
 void
 context::resume_( detail::data_t & d) noexcept {
+    get_scheduler()->get_counters().context_switches.increment();
+    get_scheduler()->trace( trace_event::suspend, d.from);
+    get_scheduler()->trace( trace_event::resume, this);
+    get_scheduler()->stamp_resume( this);
     boost::context::continuation c = c_.resume( & d);
     detail::data_t * dp = c.get_data< detail::data_t * >();
     if ( nullptr != dp) {
@@ -230,6 +249,10 @@ context::suspend_with_cc() noexcept {
     // prev will point to previous active context
     std::swap( context_initializer::active_, prev);
     detail::data_t d{ prev };
+    get_scheduler()->get_counters().context_switches.increment();
+    get_scheduler()->trace( trace_event::suspend, prev);
+    get_scheduler()->trace( trace_event::resume, this);
+    get_scheduler()->stamp_resume( this);
     // context switch
     return c_.resume( & d);
 }
@@ -250,10 +273,7 @@ context::terminate() noexcept {
     }
     BOOST_ASSERT( wait_queue_.empty() );
     // release fiber-specific-data
-    for ( fss_data_t::value_type & data : fss_data_) {
-        data.second.do_cleanup();
-    }
-    fss_data_.clear();
+    release_fss_data_();
     // switch to another context
     return get_scheduler()->terminate( lk, this);
 }
@@ -285,6 +305,7 @@ context::schedule( context * ctx) noexcept {
     //        (other scheduler assigned)
     if ( scheduler_ == ctx->get_scheduler() ) {
         // local
+        get_scheduler()->get_counters().local_wakeups.increment();
         get_scheduler()->schedule( ctx);
     } else {
         // remote
@@ -292,43 +313,61 @@ context::schedule( context * ctx) noexcept {
     }
 #else
     BOOST_ASSERT( get_scheduler() == ctx->get_scheduler() );
+    get_scheduler()->get_counters().local_wakeups.increment();
     get_scheduler()->schedule( ctx);
 #endif
 }
 
-void *
-context::get_fss_data( void const * vp) const {
-    uintptr_t key = reinterpret_cast< uintptr_t >( vp);
-    fss_data_t::const_iterator i = fss_data_.find( key);
-    return fss_data_.end() != i ? i->second.vp : nullptr;
+context::fss_data &
+context::fss_slot_( std::size_t index) {
+    if ( BOOST_LIKELY( index < BOOST_FIBERS_FSS_INLINE_SIZE) ) {
+        return fss_inline_[index];
+    }
+    index -= BOOST_FIBERS_FSS_INLINE_SIZE;
+    if ( fss_overflow_.size() <= index) {
+        fss_overflow_.resize( index + 1);
+    }
+    return fss_overflow_[index];
 }
 
 void
-context::set_fss_data( void const * vp,
+context::release_fss_data_() {
+    // a cleanup function might set fiber-specific values,
+    // each value is taken out of its slot before its cleanup
+    for ( std::size_t i = 0; i < BOOST_FIBERS_FSS_INLINE_SIZE + fss_overflow_.size(); ++i) {
+        fss_data & slot = i < BOOST_FIBERS_FSS_INLINE_SIZE
+            ? fss_inline_[i]
+            : fss_overflow_[i - BOOST_FIBERS_FSS_INLINE_SIZE];
+        fss_data data{ std::move( slot) };
+        slot = fss_data{};
+        if ( nullptr != data.vp) {
+            data.do_cleanup();
+        }
+    }
+    fss_data_t{}.swap( fss_overflow_);
+}
+
+void
+context::set_fss_data( detail::fss_key const& key,
                        detail::fss_cleanup_function::ptr_t const& cleanup_fn,
                        void * data,
                        bool cleanup_existing) {
     BOOST_ASSERT( cleanup_fn);
-    uintptr_t key = reinterpret_cast< uintptr_t >( vp);
-    fss_data_t::iterator i = fss_data_.find( key);
-    if ( fss_data_.end() != i) {
-        if( cleanup_existing) {
-            i->second.do_cleanup();
-        }
-        if ( nullptr != data) {
-            fss_data_.insert(
-                    i,
-                    std::make_pair(
-                        key,
-                        fss_data{ data, cleanup_fn } ) );
-        } else {
-            fss_data_.erase( i);
-        }
+    if ( nullptr == data &&
+         BOOST_FIBERS_FSS_INLINE_SIZE + fss_overflow_.size() <= key.index) {
+        // nothing stored, fibers without overflowing values allocate nothing
+        return;
+    }
+    fss_data & slot = fss_slot_( key.index);
+    fss_data old{ std::move( slot) };
+    if ( nullptr != data) {
+        slot = fss_data{ data, cleanup_fn, key.generation };
     } else {
-        fss_data_.insert(
-            std::make_pair(
-                key,
-                fss_data{ data, cleanup_fn } ) );
+        slot = fss_data{};
+    }
+    // a value left by a destroyed fiber_specific_ptr is always cleaned up
+    if ( nullptr != old.vp && ( cleanup_existing || key.generation != old.generation) ) {
+        old.do_cleanup();
     }
 }
 
@@ -355,7 +394,7 @@ context::remote_ready_is_linked() const noexcept {
 
 bool
 context::sleep_is_linked() const noexcept {
-    return sleep_hook_.is_linked();
+    return sleep_hook_.is_linked() || sleep_wheel_hook_.is_linked();
 }
 
 bool
@@ -383,7 +422,11 @@ context::ready_unlink() noexcept {
 void
 context::sleep_unlink() noexcept {
     BOOST_ASSERT( sleep_is_linked() );
-    sleep_hook_.unlink();
+    if ( sleep_hook_.is_linked() ) {
+        sleep_hook_.unlink();
+    } else {
+        sleep_wheel_hook_.unlink();
+    }
 }
 
 void
@@ -24,6 +24,8 @@ void
 fiber::start_() noexcept {
     context * ctx = context::active();
     ctx->attach( impl_.get() );
+    ctx->get_scheduler()->get_counters().fibers_spawned.increment();
+    ctx->get_scheduler()->trace( trace_event::spawn, impl_.get() );
     switch ( impl_->get_policy() ) {
     case launch::post:
         // push new fiber to ready-queue
@@ -0,0 +1,72 @@
+
+//          Copyright Oliver Kowalke 2013.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/detail/fss.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace detail {
+namespace {
+
+struct fss_registry {
+    std::mutex                      mtx{};
+    // current generation of each index
+    std::vector< std::size_t >      generations{};
+    // unused indices, the most recently freed index is reused first
+    std::vector< std::size_t >      free{};
+};
+
+fss_registry & registry() {
+    // never destroyed, fiber_specific_ptrs might be destroyed during static destruction
+    static fss_registry * r = new fss_registry{};
+    return * r;
+}
+
+}
+
+BOOST_FIBERS_DECL
+fss_key allocate_fss_key() {
+    fss_registry & r = registry();
+    std::unique_lock< std::mutex > lk{ r.mtx };
+    if ( ! r.free.empty() ) {
+        const std::size_t index = r.free.back();
+        r.free.pop_back();
+        return fss_key{ index, r.generations[index] };
+    }
+    // generation 0 marks unused values of a context
+    r.generations.push_back( 1);
+    return fss_key{ r.generations.size() - 1, 1 };
+}
+
+BOOST_FIBERS_DECL
+void deallocate_fss_key( fss_key const& key) noexcept {
+    fss_registry & r = registry();
+    std::unique_lock< std::mutex > lk{ r.mtx };
+    BOOST_ASSERT( key.index < r.generations.size() );
+    BOOST_ASSERT( key.generation == r.generations[key.index]);
+    ++r.generations[key.index];
+    try {
+        r.free.push_back( key.index);
+    } catch (...) {
+        // index is not reused
+    }
+}
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,161 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/numa/memory.hpp"
+
+extern "C" {
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+#include <cstdint>
+#include <new>
+
+#include <boost/assert.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace {
+
+// values of <numaif.h>, the system calls are invoked directly
+// in order to avoid a dependency on libnuma
+constexpr int mpol_preferred = 1;
+constexpr int mpol_mf_move = 1 << 1;
+// pages passed to one call of move_pages()
+constexpr std::size_t migrate_batch = 64;
+constexpr std::size_t mask_words = 16;
+constexpr std::size_t word_bits = 8 * sizeof( unsigned long);
+thread_local std::uint32_t this_node = boost::fibers::numa::unknown_node;
+
+}
+
+namespace boost {
+namespace fibers {
+namespace numa {
+
+BOOST_FIBERS_DECL
+std::uint32_t current_node() noexcept {
+    if ( unknown_node != this_node) {
+        return this_node;
+    }
+    unsigned int cpu = 0, node = 0;
+    if ( 0 != ::syscall( SYS_getcpu, & cpu, & node, nullptr) ) {
+        return 0;
+    }
+    return node;
+}
+
+BOOST_FIBERS_DECL
+void set_current_node( std::uint32_t node_id) noexcept {
+    this_node = node_id;
+}
+
+BOOST_FIBERS_DECL
+std::uint32_t announced_node() noexcept {
+    return this_node;
+}
+
+BOOST_FIBERS_DECL
+std::uint32_t memory_node( void const* vp) noexcept {
+    const std::uintptr_t page_size = ::sysconf( _SC_PAGESIZE);
+    void * page = reinterpret_cast< void * >( reinterpret_cast< std::uintptr_t >( vp) & ~ ( page_size - 1) );
+    int status = -1;
+    // nodes == nullptr: the pages are not moved, status reports their node
+    if ( 0 != ::syscall( SYS_move_pages, 0, 1, & page, nullptr, & status, 0) || 0 > status) {
+        return unknown_node;
+    }
+    return static_cast< std::uint32_t >( status);
+}
+
+BOOST_FIBERS_DECL
+bool bind_memory( void * vp, std::size_t size, std::uint32_t node_id) noexcept {
+    // the kernel evaluates maxnode - 1 bits of the mask
+    if ( mask_words * word_bits - 1 <= node_id) {
+        return false;
+    }
+    unsigned long mask[mask_words] = { 0 };
+    mask[node_id / word_bits] = 1ul << ( node_id % word_bits);
+    // preferred (not strict) binding: pages are allocated from other
+    // NUMA nodes if node_id runs out of memory
+    return 0 == ::syscall( SYS_mbind, vp, size, mpol_preferred, mask, mask_words * word_bits, 0);
+}
+
+BOOST_FIBERS_DECL
+std::size_t migrate_memory( void * vp, std::size_t size, std::uint32_t node_id) noexcept {
+    const std::uintptr_t page_size = ::sysconf( _SC_PAGESIZE);
+    std::uintptr_t address = reinterpret_cast< std::uintptr_t >( vp) & ~ ( page_size - 1);
+    const std::uintptr_t end = reinterpret_cast< std::uintptr_t >( vp) + size;
+    void * pages[migrate_batch];
+    int nodes[migrate_batch];
+    int status[migrate_batch];
+    std::size_t migrated = 0;
+    while ( address < end) {
+        std::size_t count = 0;
+        for ( ; count < migrate_batch && address < end; ++count, address += page_size) {
+            pages[count] = reinterpret_cast< void * >( address);
+        }
+        // query the nodes of the pages (nodes == nullptr), status of a
+        // page is its node or a negative error code (not faulted in)
+        if ( 0 > ::syscall( SYS_move_pages, 0, count, pages, nullptr, status, 0) ) {
+            break;
+        }
+        // only resident pages located on another node are moved
+        std::size_t remote = 0;
+        for ( std::size_t i = 0; i < count; ++i) {
+            if ( 0 <= status[i] && static_cast< int >( node_id) != status[i]) {
+                pages[remote] = pages[i];
+                nodes[remote] = static_cast< int >( node_id);
+                ++remote;
+            }
+        }
+        if ( 0 == remote) {
+            continue;
+        }
+        // pages of the calling process, only pages not shared with
+        // other processes are moved
+        if ( 0 > ::syscall( SYS_move_pages, 0, remote, pages, nodes, status, mpol_mf_move) ) {
+            break;
+        }
+        for ( std::size_t i = 0; i < remote; ++i) {
+            if ( static_cast< int >( node_id) == status[i]) {
+                ++migrated;
+            }
+        }
+    }
+    return migrated;
+}
+
+BOOST_FIBERS_DECL
+void * allocate_memory( std::size_t size, std::uint32_t node_id) {
+    void * vp = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( MAP_FAILED == vp) {
+        throw std::bad_alloc();
+    }
+    if ( ! bind_memory( vp, size, node_id) ) {
+        // first-touch policy: only the top page (initial stack frames and
+        // the fiber's context) is touched, the remaining pages are placed
+        // by the thread faulting them in; touching every page would commit
+        // the full stack size
+        const std::size_t page_size = ::sysconf( _SC_PAGESIZE);
+        static_cast< volatile char * >( vp)[size - page_size] = 0;
+    }
+    return vp;
+}
+
+BOOST_FIBERS_DECL
+void deallocate_memory( void * vp, std::size_t size) noexcept {
+    BOOST_ASSERT( nullptr != vp);
+    ::munmap( vp, size);
+}
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
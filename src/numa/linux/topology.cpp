@@ -124,6 +124,57 @@ std::vector< std::uint32_t > distance_from_line( std::string const& content) {
     return distance;
 }
 
+std::set< std::uint32_t > ids_from_file( fs::path const& path) {
+    if ( ! fs::exists( path) ) {
+        return std::set< std::uint32_t >{};
+    }
+    fs::ifstream fs_ids{ path };
+    std::string content;
+    std::getline( fs_ids, content);
+    if ( content.empty() ) {
+        return std::set< std::uint32_t >{};
+    }
+    return ids_from_line( content);
+}
+
+boost::fibers::numa::cpu_siblings siblings_of( std::uint32_t cpu_id, fs::path const& cpu_path) {
+    boost::fibers::numa::cpu_siblings siblings;
+    // hardware threads of the same core
+    siblings.core = ids_from_file( cpu_path / "topology/thread_siblings_list");
+    // data and unified caches shared with other logical cpus
+    fs::path cache_path{ cpu_path / "cache" };
+    if ( fs::exists( cache_path) ) {
+        directory_iterator e;
+        for ( directory_iterator i{ cache_path, "^index([0-9]+)$" };
+              i != e; ++i) {
+            fs::ifstream fs_level{ i->second / "level" };
+            std::string level;
+            std::getline( fs_level, level);
+            fs::ifstream fs_type{ i->second / "type" };
+            std::string type;
+            std::getline( fs_type, type);
+            if ( "Instruction" == type) {
+                continue;
+            }
+            if ( "2" == level) {
+                siblings.l2_cache = ids_from_file( i->second / "shared_cpu_list");
+            } else if ( "3" == level) {
+                siblings.l3_cache = ids_from_file( i->second / "shared_cpu_list");
+            }
+        }
+    }
+    if ( ! siblings.core.empty() ) {
+        siblings.core.insert( cpu_id);
+    }
+    if ( ! siblings.l2_cache.empty() ) {
+        siblings.l2_cache.insert( cpu_id);
+    }
+    if ( ! siblings.l3_cache.empty() ) {
+        siblings.l3_cache.insert( cpu_id);
+    }
+    return siblings;
+}
+
 }
 
 namespace boost {
@@ -156,6 +207,8 @@ std::vector< node > topology() {
             std::uint32_t node_id = i->first;
             map[node_id].id = node_id;
             map[node_id].logical_cpus.insert( cpu_id);
+            // 3. logical cpus sharing the core and caches
+            map[node_id].siblings[cpu_id] = siblings_of( cpu_id, cpu_path);
             // assigned to only one NUMA node
             break;
         }
@@ -166,6 +219,8 @@ std::vector< node > topology() {
         map[0].id = 0;
         for ( std::uint32_t cpu_id : cpus) {
             map[0].logical_cpus.insert( cpu_id);
+            map[0].siblings[cpu_id] = siblings_of( cpu_id,
+                fs::path{ boost::str( boost::format("/sys/devices/system/cpu/cpu%d/") % cpu_id) });
         }
     }
     for ( auto entry : map) {
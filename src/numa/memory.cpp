@@ -0,0 +1,81 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/numa/memory.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <boost/assert.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+// placement of memory is not supported, the pages are
+// placed by the operating system (usually first touch)
+
+namespace {
+
+thread_local std::uint32_t this_node = boost::fibers::numa::unknown_node;
+
+}
+
+namespace boost {
+namespace fibers {
+namespace numa {
+
+BOOST_FIBERS_DECL
+std::uint32_t current_node() noexcept {
+    return unknown_node != this_node ? this_node : 0;
+}
+
+BOOST_FIBERS_DECL
+void set_current_node( std::uint32_t node_id) noexcept {
+    this_node = node_id;
+}
+
+BOOST_FIBERS_DECL
+std::uint32_t announced_node() noexcept {
+    return this_node;
+}
+
+BOOST_FIBERS_DECL
+std::uint32_t memory_node( void const*) noexcept {
+    return unknown_node;
+}
+
+BOOST_FIBERS_DECL
+bool bind_memory( void *, std::size_t, std::uint32_t) noexcept {
+    return false;
+}
+
+BOOST_FIBERS_DECL
+std::size_t migrate_memory( void *, std::size_t, std::uint32_t) noexcept {
+    return 0;
+}
+
+BOOST_FIBERS_DECL
+void * allocate_memory( std::size_t size, std::uint32_t) {
+    void * vp = std::malloc( size);
+    if ( nullptr == vp) {
+        throw std::bad_alloc();
+    }
+    return vp;
+}
+
+BOOST_FIBERS_DECL
+void deallocate_memory( void * vp, std::size_t) noexcept {
+    BOOST_ASSERT( nullptr != vp);
+    std::free( vp);
+}
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,133 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/pool.hpp"
+
+#include <system_error>
+
+#include <boost/assert.hpp>
+
+#include "boost/fiber/channel_op_status.hpp"
+#include "boost/fiber/exceptions.hpp"
+#include "boost/fiber/fiber.hpp"
+#include "boost/fiber/numa/pin_thread.hpp"
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+
+void
+pool::worker_( std::uint32_t idx) {
+    if ( ! cpus_.empty() ) {
+        numa::pin_thread( cpus_[idx % cpus_.size()]);
+    }
+    init_( idx);
+    {
+        // all workers have to install their algorithm
+        // before fibers are launched (work-stealing)
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        if ( thread_count_ == ++started_) {
+            started_cnd_.notify_all();
+        } else {
+            started_cnd_.wait( lk, [this](){ return thread_count_ == started_; });
+        }
+    }
+    // returns after the queue has been closed and drained
+    fiber{ & pool::receive_, this }.join();
+    // wait for tasks still running (might run in this thread)
+    std::unique_lock< std::mutex > lk{ mtx_ };
+    drained_cnd_.wait( lk, [this](){ return 0 == pending_; });
+}
+
+void
+pool::receive_( pool * self) {
+    task_ptr t;
+    while ( channel_op_status::success == self->queue_.pop( t) ) {
+        fiber{ & pool::run_, self, std::move( t) }.detach();
+    }
+}
+
+void
+pool::run_( pool * self, task_ptr t) {
+    t->run();
+    t.reset();
+    std::unique_lock< std::mutex > lk{ self->mtx_ };
+    if ( 0 == --self->pending_) {
+        lk.unlock();
+        self->drained_cnd_.notify_all();
+    }
+}
+
+void
+pool::submit_( task_ptr t) {
+    {
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        if ( shutdown_) {
+            throw fiber_error{ std::make_error_code( std::errc::operation_not_permitted),
+                               "boost fiber: pool has been shut down" };
+        }
+        ++pending_;
+    }
+    if ( channel_op_status::success != queue_.push( std::move( t) ) ) {
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        if ( 0 == --pending_) {
+            lk.unlock();
+            drained_cnd_.notify_all();
+        }
+        throw fiber_error{ std::make_error_code( std::errc::operation_not_permitted),
+                           "boost fiber: pool has been shut down" };
+    }
+}
+
+pool::pool( std::uint32_t thread_count,
+            initializer_type init,
+            std::vector< std::uint32_t > cpus) :
+    thread_count_{ thread_count },
+    init_( std::move( init) ),
+    cpus_( std::move( cpus) ),
+    queue_{ BOOST_FIBERS_POOL_QUEUE_CAPACITY } {
+    if ( 0 == thread_count_) {
+        throw fiber_error{ std::make_error_code( std::errc::invalid_argument),
+                           "boost fiber: pool requires at least one thread" };
+    }
+    BOOST_ASSERT( init_);
+    threads_.reserve( thread_count_);
+    for ( std::uint32_t i = 0; i < thread_count_; ++i) {
+        threads_.emplace_back( & pool::worker_, this, i);
+    }
+    // return if all workers are ready
+    std::unique_lock< std::mutex > lk{ mtx_ };
+    started_cnd_.wait( lk, [this](){ return thread_count_ == started_; });
+}
+
+pool::~pool() {
+    shutdown();
+}
+
+void
+pool::shutdown() {
+    {
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        if ( shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+    }
+    // wakes up the receivers (parked workers are notified),
+    // queued tasks are still delivered
+    queue_.close();
+    for ( std::thread & t : threads_) {
+        t.join();
+    }
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
@@ -8,6 +8,7 @@
 
 #include <chrono>
 #include <mutex>
+#include <thread>
 
 #include <boost/assert.hpp>
 
@@ -40,6 +41,13 @@ scheduler::release_terminated_() noexcept {
         BOOST_ASSERT( ! ctx->wait_is_linked() );
         BOOST_ASSERT( ctx->wait_queue_.empty() );
         BOOST_ASSERT( ctx->terminated_);
+        if ( nullptr != ctx->stack_site_) {
+            // deepest touched offset of the stack
+            detail::record_stack_usage(
+                    ctx->stack_site_,
+                    static_cast< char * >( ctx->stack_bottom_) + ctx->stack_site_->guard_size,
+                    ctx->stack_top_);
+        }
         // if last reference, e.g. fiber::join() or fiber::detach()
         // have been already called, this will call ~context(),
         // the context is automatically removeid from worker-queue
@@ -50,19 +58,16 @@ scheduler::release_terminated_() noexcept {
 #if ! defined(BOOST_FIBERS_NO_ATOMICS)
 void
 scheduler::remote_ready2ready_() noexcept {
-    remote_ready_queue_type tmp;
-    detail::spinlock_lock lk{ remote_ready_splk_ };
-    remote_ready_queue_.swap( tmp);
-    lk.unlock();
-    // get context from remote ready-queue
-    while ( ! tmp.empty() ) {
-        context * ctx = & tmp.front();
-        tmp.pop_front();
+    // drain remote ready-queue; a context is pushed at most once
+    // until it has been resumed by this scheduler, so draining terminates
+    context * ctx = nullptr;
+    while ( nullptr != ( ctx = remote_ready_queue_.pop() ) ) {
         // ctx was signaled from remote (other thread)
         // ctx might have been already resumed because of
         // its wait-op. has been already timed out and
         // thus it was already pushed to the ready-queue
         if ( ! ctx->ready_is_linked() ) {
+            counters_.remote_wakeups.increment();
             // store context in local queues
             schedule( ctx);
         }
@@ -70,38 +75,70 @@ scheduler::remote_ready2ready_() noexcept {
 }
 #endif
 
+void
+scheduler::sleep_link_( context * ctx) noexcept {
+    if ( sleep_wheel_) {
+        sleep_wheel_->insert( ctx);
+    } else {
+        ctx->sleep_link( sleep_queue_);
+    }
+}
+
+void
+scheduler::sleep_expired_( context * ctx) noexcept {
+    // dipatcher context must never be pushed to sleep-queue
+    BOOST_ASSERT( ! ctx->is_context( type::dispatcher_context) );
+    BOOST_ASSERT( main_ctx_ == ctx || ctx->worker_is_linked() );
+    BOOST_ASSERT( ! ctx->ready_is_linked() );
+#if ! defined(BOOST_FIBERS_NO_ATOMICS)
+    BOOST_ASSERT( ! ctx->remote_ready_is_linked() );
+#endif
+    BOOST_ASSERT( ! ctx->terminated_is_linked() );
+    BOOST_ASSERT( ! ctx->sleep_is_linked() );
+    // reset sleep-tp
+    ctx->tp_ = (std::chrono::steady_clock::time_point::max)();
+    std::intptr_t prev = ctx->twstatus.exchange( -1);
+    if ( static_cast< std::intptr_t >( -1) ==  prev) {
+        // timed-wait op.: timeout after notify
+        return;
+    }
+    // prev == 0: no timed-wait op.
+    // prev == <any>: timed-wait op., timeout before notify
+    // push new context to ready-queue
+    trace( trace_event::wake, ctx);
+    algo_->awakened( ctx);
+}
+
+void
+scheduler::suspend_until_( std::chrono::steady_clock::time_point const& suspend_time) noexcept {
+    counters_.parks.increment();
+    trace( trace_event::park, nullptr);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    algo_->suspend_until( suspend_time);
+    trace( trace_event::unpark, nullptr);
+    counters_.park_time.increment( static_cast< std::uint64_t >(
+            std::chrono::duration_cast< std::chrono::nanoseconds >(
+                std::chrono::steady_clock::now() - start).count() ) );
+}
+
 void
 scheduler::sleep2ready_() noexcept {
     // move context which the deadline has reached
     // to ready-queue
-    // sleep-queue is sorted (ascending)
     std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if ( sleep_wheel_) {
+        sleep_wheel_->expire( now, [this]( context * ctx) { sleep_expired_( ctx); });
+        return;
+    }
+    // sleep-queue is sorted (ascending)
     sleep_queue_type::iterator e = sleep_queue_.end();
     for ( sleep_queue_type::iterator i = sleep_queue_.begin(); i != e;) {
         context * ctx = & ( * i);
-        // dipatcher context must never be pushed to sleep-queue
-        BOOST_ASSERT( ! ctx->is_context( type::dispatcher_context) );
-        BOOST_ASSERT( main_ctx_ == ctx || ctx->worker_is_linked() );
-        BOOST_ASSERT( ! ctx->ready_is_linked() );
-#if ! defined(BOOST_FIBERS_NO_ATOMICS)
-        BOOST_ASSERT( ! ctx->remote_ready_is_linked() );
-#endif
-        BOOST_ASSERT( ! ctx->terminated_is_linked() );
         // set fiber to state_ready if deadline was reached
         if ( ctx->tp_ <= now) {
             // remove context from sleep-queue
             i = sleep_queue_.erase( i);
-            // reset sleep-tp
-            ctx->tp_ = (std::chrono::steady_clock::time_point::max)();
-            std::intptr_t prev = ctx->twstatus.exchange( -1);
-            if ( static_cast< std::intptr_t >( -1) ==  prev) {
-                // timed-wait op.: timeout after notify
-                continue;
-            }
-            // prev == 0: no timed-wait op.
-            // prev == <any>: timed-wait op., timeout before notify
-            // push new context to ready-queue
-            algo_->awakened( ctx);
+            sleep_expired_( ctx);
         } else {
             break; // first context with now < deadline
         }
@@ -116,13 +153,8 @@ scheduler::~scheduler() {
     BOOST_ASSERT( nullptr != main_ctx_);
     BOOST_ASSERT( nullptr != dispatcher_ctx_.get() );
     BOOST_ASSERT( context::active() == main_ctx_);
-#if ! defined(BOOST_FIBERS_NO_ATOMICS)
-    // protect for concurrent access
-    // required because main-context might have been
-    // signaled from remote and algorithm::notify()
-    // must be called fro mremote too
-    detail::spinlock_lock lk{ remote_ready_splk_ };
-#endif
+    // no longer watched
+    watchdog::detach_( this);
     // signal dispatcher-context termination
     shutdown_ = true;
     // resume pending fibers
@@ -132,6 +164,7 @@ scheduler::~scheduler() {
     BOOST_ASSERT( worker_queue_.empty() );
     BOOST_ASSERT( terminated_queue_.empty() );
     BOOST_ASSERT( sleep_queue_.empty() );
+    BOOST_ASSERT( ! sleep_wheel_ || sleep_wheel_->empty() );
     // set active context to nullptr
     context::reset_active();
     // deallocate dispatcher-context
@@ -139,6 +172,14 @@ scheduler::~scheduler() {
     dispatcher_ctx_.reset();
     // set main-context to nullptr
     main_ctx_ = nullptr;
+#if ! defined(BOOST_FIBERS_NO_ATOMICS)
+    // a remote thread might still be inside schedule_from_remote() after
+    // it has pushed a context that has already been resumed (and has
+    // terminated or destroyed this scheduler from the main-context)
+    while ( 0 != remote_producers_.load( std::memory_order_acquire) ) {
+        std::this_thread::yield();
+    }
+#endif
 }
 
 boost::context::continuation
@@ -183,12 +224,29 @@ scheduler::dispatch() noexcept {
             std::chrono::steady_clock::time_point suspend_time =
                     (std::chrono::steady_clock::time_point::max)();
             // get lowest deadline from sleep-queue
-            sleep_queue_type::iterator i = sleep_queue_.begin();
-            if ( sleep_queue_.end() != i) {
-                suspend_time = i->tp_;
+            if ( sleep_wheel_) {
+                suspend_time = sleep_wheel_->next_deadline();
+            } else {
+                sleep_queue_type::iterator i = sleep_queue_.begin();
+                if ( sleep_queue_.end() != i) {
+                    suspend_time = i->tp_;
+                }
             }
             // no ready context, wait till signaled
-            algo_->suspend_until( suspend_time);
+#if ! defined(BOOST_FIBERS_NO_ATOMICS)
+            // announce that the dispatcher is going to be parked,
+            // afterwards re-check the remote ready-queue so that
+            // a concurrent schedule_from_remote() either sees
+            // parked_ or its context is found here
+            parked_.store( true, std::memory_order_relaxed);
+            std::atomic_thread_fence( std::memory_order_seq_cst);
+            if ( remote_ready_queue_.empty() ) {
+                suspend_until_( suspend_time);
+            }
+            parked_.store( false, std::memory_order_relaxed);
+#else
+            suspend_until_( suspend_time);
+#endif
         }
     }
     // release termianted context'
@@ -213,6 +271,7 @@ scheduler::schedule( context * ctx) noexcept {
         ctx->sleep_unlink();
     }
     // push new context to ready-queue
+    trace( trace_event::wake, ctx);
     algo_->awakened( ctx);
 }
 
@@ -227,15 +286,39 @@ scheduler::schedule_from_remote( context * ctx) noexcept {
     BOOST_ASSERT( ! ctx->remote_ready_is_linked() );
     BOOST_ASSERT( ! ctx->terminated_is_linked() );
     BOOST_ASSERT( ! ctx->wait_is_linked() );
-    // protect for concurrent access
-    detail::spinlock_lock lk{ remote_ready_splk_ };
     BOOST_ASSERT( ! shutdown_);
     BOOST_ASSERT( nullptr != main_ctx_);
     BOOST_ASSERT( nullptr != dispatcher_ctx_.get() );
+    trace( trace_event::remote_wake, ctx);
+    // once ctx is pushed it might be resumed and this scheduler destroyed:
+    // the push and the park/notify protocol below are the only accesses
+    // after the push, both are covered by the guard (~scheduler() waits
+    // for remote_producers_ to drain)
+    struct producer_guard {
+        std::atomic< std::size_t >  &   count;
+
+        explicit producer_guard( std::atomic< std::size_t > & count_) noexcept :
+            count( count_) {
+            count.fetch_add( 1, std::memory_order_acq_rel);
+        }
+
+        ~producer_guard() {
+            // last access to the scheduler
+            count.fetch_sub( 1, std::memory_order_release);
+        }
+    };
+    producer_guard guard{ remote_producers_ };
     // push new context to remote ready-queue
-    ctx->remote_ready_link( remote_ready_queue_);
-    // notify scheduler
-    algo_->notify();
+    // lock-free, producers never spin
+    remote_ready_queue_.push( ctx);
+    // pairs with the fence in dispatch()
+    std::atomic_thread_fence( std::memory_order_seq_cst);
+    // notify scheduler only if its dispatcher is parked,
+    // otherwise ctx is picked up by the next run of dispatch()
+    if ( parked_.load( std::memory_order_relaxed) ) {
+        counters_.unparks.fetch_add( 1, std::memory_order_relaxed);
+        algo_->notify();
+    }
 }
 #endif
 
@@ -254,6 +337,8 @@ scheduler::terminate( detail::spinlock_lock & lk, context * ctx) noexcept {
     BOOST_ASSERT( ! ctx->terminated_is_linked() );
     BOOST_ASSERT( ! ctx->wait_is_linked() );
     BOOST_ASSERT( ctx->wait_queue_.empty() );
+    counters_.fibers_terminated.increment();
+    trace( trace_event::terminate, ctx);
     // store the terminated fiber in the terminated-queue
     // the dispatcher-context will call
     ctx->terminated_link( terminated_queue_);
@@ -295,7 +380,8 @@ scheduler::wait_until( context * ctx,
     BOOST_ASSERT( ! ctx->terminated_is_linked() );
     BOOST_ASSERT( ! ctx->wait_is_linked() );
     ctx->tp_ = sleep_tp;
-    ctx->sleep_link( sleep_queue_);
+    sleep_link_( ctx);
+    trace( trace_event::block, ctx);
     // resume another context
     algo_->pick_next()->resume();
     // context has been resumed
@@ -320,7 +406,8 @@ scheduler::wait_until( context * ctx,
     // if context was locked inside timed_mutex::try_lock_until()
     // push active context to sleep-queue
     ctx->tp_ = sleep_tp;
-    ctx->sleep_link( sleep_queue_);
+    sleep_link_( ctx);
+    trace( trace_event::block, ctx);
     // resume another context
     algo_->pick_next()->resume( lk);
     // context has been resumed
@@ -330,16 +417,25 @@ scheduler::wait_until( context * ctx,
 
 void
 scheduler::suspend() noexcept {
+    trace( trace_event::block, context::active() );
     // resume another context
     algo_->pick_next()->resume();
 }
 
 void
 scheduler::suspend( detail::spinlock_lock & lk) noexcept {
+    trace( trace_event::block, context::active() );
     // resume another context
     algo_->pick_next()->resume( lk);
 }
 
+scheduler_statistics
+scheduler::get_statistics() const noexcept {
+    scheduler_statistics stats;
+    counters_.snapshot( stats);
+    return stats;
+}
+
 bool
 scheduler::has_ready_fibers() const noexcept {
     return algo_->has_ready_fibers();
@@ -354,6 +450,27 @@ scheduler::set_algo( algo::algorithm::ptr_t algo) noexcept {
     algo_ = std::move( algo);
 }
 
+void
+scheduler::set_sleep_queue_policy( sleep_queue_policy policy) {
+    if ( policy == get_sleep_queue_policy() ) {
+        return;
+    }
+    // move sleeping context' to the new sleep-queue
+    if ( sleep_queue_policy::timer_wheel == policy) {
+        sleep_wheel_.reset( new detail::timer_wheel{} );
+        while ( ! sleep_queue_.empty() ) {
+            context * ctx = & ( * sleep_queue_.begin() );
+            sleep_queue_.erase( sleep_queue_.begin() );
+            sleep_wheel_->insert( ctx);
+        }
+    } else {
+        std::unique_ptr< detail::timer_wheel > wheel{ std::move( sleep_wheel_) };
+        for ( context * ctx = wheel->pop(); nullptr != ctx; ctx = wheel->pop() ) {
+            ctx->sleep_link( sleep_queue_);
+        }
+    }
+}
+
 void
 scheduler::attach_main_context( context * ctx) noexcept {
     BOOST_ASSERT( nullptr != ctx);
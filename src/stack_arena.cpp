@@ -0,0 +1,150 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/arena_fixedsize_stack.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include <boost/predef.h>
+
+#if BOOST_OS_UNIX || BOOST_OS_MACOS
+extern "C" {
+#include <sys/mman.h>
+}
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace detail {
+namespace {
+
+#if BOOST_OS_LINUX
+std::size_t read_huge_page_size() noexcept {
+    try {
+        std::ifstream meminfo{ "/proc/meminfo" };
+        std::string key;
+        while ( meminfo >> key) {
+            if ( "Hugepagesize:" == key) {
+                std::size_t kb = 0;
+                if ( meminfo >> kb) {
+                    return kb * 1024;
+                }
+                break;
+            }
+            meminfo.ignore( 256, '\n');
+        }
+    } catch (...) {
+    }
+    // x86_64 and AArch64 with 4K base pages
+    return 2 * 1024 * 1024;
+}
+#endif
+
+}
+
+BOOST_FIBERS_DECL
+std::size_t huge_page_size() noexcept {
+#if BOOST_OS_LINUX
+    static const std::size_t size = read_huge_page_size();
+    return size;
+#else
+    return 0;
+#endif
+}
+
+BOOST_FIBERS_DECL
+void * allocate_arena_chunk( std::size_t size, huge_page_policy policy, bool & huge) {
+    huge = false;
+#if BOOST_OS_UNIX || BOOST_OS_MACOS
+# if defined(MAP_HUGETLB)
+    if ( huge_page_policy::hugetlb == policy) {
+        // fails if no pre-allocated huge pages are available
+        void * vp = ::mmap( nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if ( MAP_FAILED != vp) {
+            huge = true;
+            return vp;
+        }
+    }
+# endif
+    const std::size_t alignment = huge_page_policy::none != policy ? huge_page_size() : 0;
+    // over-allocate to align the chunk to the huge page size
+    const std::size_t mapped = size + alignment;
+    void * vp = ::mmap( nullptr, mapped, PROT_READ | PROT_WRITE,
+# if defined(MAP_ANONYMOUS)
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+# else
+                        MAP_PRIVATE | MAP_ANON,
+# endif
+                        -1, 0);
+    if ( MAP_FAILED == vp) {
+        throw std::bad_alloc();
+    }
+    std::uintptr_t first = reinterpret_cast< std::uintptr_t >( vp);
+    if ( 0 != alignment) {
+        const std::uintptr_t aligned = ( first + alignment - 1) & ~ static_cast< std::uintptr_t >( alignment - 1);
+        if ( aligned != first) {
+            ::munmap( vp, aligned - first);
+        }
+        const std::uintptr_t last = aligned + size;
+        const std::uintptr_t end = first + mapped;
+        if ( last != end) {
+            ::munmap( reinterpret_cast< void * >( last), end - last);
+        }
+        first = aligned;
+    }
+    vp = reinterpret_cast< void * >( first);
+# if defined(MADV_HUGEPAGE)
+    if ( 0 != alignment) {
+        // fails if transparent huge pages are disabled
+        huge = 0 == ::madvise( vp, size, MADV_HUGEPAGE);
+    }
+# endif
+    return vp;
+#else
+    (void)policy;
+    void * vp = std::malloc( size);
+    if ( nullptr == vp) {
+        throw std::bad_alloc();
+    }
+    return vp;
+#endif
+}
+
+BOOST_FIBERS_DECL
+void deallocate_arena_chunk( void * vp, std::size_t size) noexcept {
+#if BOOST_OS_UNIX || BOOST_OS_MACOS
+    ::munmap( vp, size);
+#else
+    (void)size;
+    std::free( vp);
+#endif
+}
+
+BOOST_FIBERS_DECL
+bool protect_arena_guard( void * vp, std::size_t size) noexcept {
+#if BOOST_OS_UNIX || BOOST_OS_MACOS
+    // fails for huge pages of hugetlbfs, the guard is a gap only
+    return 0 == ::mprotect( vp, size, PROT_NONE);
+#else
+    (void)vp;
+    (void)size;
+    return false;
+#endif
+}
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
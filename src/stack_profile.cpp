@@ -0,0 +1,166 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/stack_profile.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+#include <boost/assert.hpp>
+#include <boost/core/demangle.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace {
+
+// written to the unused part of the stacks of profiled fibers
+constexpr std::uintptr_t fill_pattern = static_cast< std::uintptr_t >( 0xcdcdcdcdcdcdcdcdull);
+
+std::atomic< bool > profiling{
+#if defined(BOOST_FIBERS_ENABLE_STACK_PROFILING)
+    true
+#else
+    false
+#endif
+};
+
+struct usage_record {
+    std::uint64_t   fibers{ 0 };
+    std::size_t     max_used{ 0 };
+    std::uint64_t   sum_used{ 0 };
+};
+
+typedef std::pair< detail::stack_profile_site const*, std::size_t >   usage_key;
+
+// records of all threads, keyed by allocator and stack size
+struct usage_registry {
+    std::mutex                              mtx{};
+    std::map< usage_key, usage_record >     records{};
+};
+
+usage_registry & registry() {
+    // never destroyed, fibers might terminate during static destruction
+    static usage_registry * r = new usage_registry{};
+    return * r;
+}
+
+std::uintptr_t align_up( void * vp) noexcept {
+    const std::uintptr_t mask = sizeof( std::uintptr_t) - 1;
+    return ( reinterpret_cast< std::uintptr_t >( vp) + mask) & ~ mask;
+}
+
+}
+
+BOOST_FIBERS_DECL
+void enable_stack_profiling( bool enable) noexcept {
+    profiling.store( enable, std::memory_order_relaxed);
+}
+
+BOOST_FIBERS_DECL
+bool stack_profiling_enabled() noexcept {
+    return profiling.load( std::memory_order_relaxed);
+}
+
+BOOST_FIBERS_DECL
+std::vector< stack_usage > get_stack_usage() {
+    usage_registry & r = registry();
+    std::vector< stack_usage > usage;
+    std::unique_lock< std::mutex > lk{ r.mtx };
+    for ( auto & e : r.records) {
+        stack_usage u;
+        // the site stores the name returned by typeid(), demangled
+        // outside of the hot path
+        u.allocator = boost::core::demangle( e.first.first->name);
+        u.stack_size = e.first.second;
+        u.fibers = e.second.fibers;
+        u.max_used = e.second.max_used;
+        u.mean_used = static_cast< std::size_t >( e.second.sum_used / e.second.fibers);
+        usage.push_back( std::move( u) );
+    }
+    return usage;
+}
+
+BOOST_FIBERS_DECL
+void reset_stack_usage() noexcept {
+    usage_registry & r = registry();
+    std::unique_lock< std::mutex > lk{ r.mtx };
+    r.records.clear();
+}
+
+BOOST_FIBERS_DECL
+void write_stack_usage( std::ostream & os) {
+    os << std::left << std::setw( 40) << "allocator"
+       << std::right << std::setw( 12) << "stack size"
+       << std::setw( 12) << "fibers"
+       << std::setw( 12) << "max used"
+       << std::setw( 12) << "mean used"
+       << std::setw( 8) << "max %" << '\n';
+    for ( stack_usage const& u : get_stack_usage() ) {
+        os << std::left << std::setw( 40) << u.allocator
+           << std::right << std::setw( 12) << u.stack_size
+           << std::setw( 12) << u.fibers
+           << std::setw( 12) << u.max_used
+           << std::setw( 12) << u.mean_used
+           << std::setw( 8) << ( 0 != u.stack_size ? 100 * u.max_used / u.stack_size : 0) << '\n';
+    }
+    os.flush();
+}
+
+namespace detail {
+
+BOOST_FIBERS_DECL
+void fill_stack( void * bottom, void * top) noexcept {
+    std::uintptr_t * first = reinterpret_cast< std::uintptr_t * >( align_up( bottom) );
+    std::uintptr_t * last = static_cast< std::uintptr_t * >( top);
+    for ( ; first < last; ++first) {
+        * first = fill_pattern;
+    }
+}
+
+BOOST_FIBERS_DECL
+void record_stack_usage( stack_profile_site const* site, void * bottom, void * top) noexcept {
+    BOOST_ASSERT( nullptr != site);
+    // the stack grows downwards, the deepest touched word
+    // is the lowest word not equal to the pattern
+    std::uintptr_t const* first = reinterpret_cast< std::uintptr_t const* >( align_up( bottom) );
+    std::uintptr_t const* last = static_cast< std::uintptr_t const* >( top);
+    while ( first < last && fill_pattern == * first) {
+        ++first;
+    }
+    const std::size_t used = static_cast< std::size_t >(
+            reinterpret_cast< char const* >( last) - reinterpret_cast< char const* >( first) );
+    const std::size_t size = static_cast< std::size_t >(
+            static_cast< char * >( top) - static_cast< char * >( bottom) );
+    usage_registry & r = registry();
+    try {
+        std::unique_lock< std::mutex > lk{ r.mtx };
+        usage_record & rec = r.records[usage_key{ site, size }];
+        ++rec.fibers;
+        if ( used > rec.max_used) {
+            rec.max_used = used;
+        }
+        rec.sum_used += used;
+    } catch (...) {
+        // record dropped
+    }
+}
+
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,70 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/stack_release.hpp"
+
+#include <cstdint>
+
+#include <boost/context/stack_traits.hpp>
+#include <boost/predef.h>
+
+#if BOOST_OS_UNIX || BOOST_OS_MACOS
+extern "C" {
+#include <sys/mman.h>
+}
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace detail {
+
+BOOST_FIBERS_DECL
+bool release_stack_memory( void * bottom, void * top, std::size_t watermark, bool lazy) noexcept {
+#if ( BOOST_OS_UNIX || BOOST_OS_MACOS ) && ( defined(MADV_FREE) || defined(MADV_DONTNEED) )
+    const std::uintptr_t page_size = boost::context::stack_traits::page_size();
+    // pages partially used by the allocator (e.g. a header at the bottom)
+    // and the top watermark bytes are kept
+    const std::uintptr_t first = ( reinterpret_cast< std::uintptr_t >( bottom) + page_size - 1) & ~ ( page_size - 1);
+    const std::uintptr_t top_ = reinterpret_cast< std::uintptr_t >( top);
+    if ( top_ - reinterpret_cast< std::uintptr_t >( bottom) <= watermark) {
+        return true;
+    }
+    const std::uintptr_t last = ( top_ - watermark) & ~ ( page_size - 1);
+    if ( first >= last) {
+        return true;
+    }
+    void * vp = reinterpret_cast< void * >( first);
+    const std::size_t size = static_cast< std::size_t >( last - first);
+# if defined(MADV_FREE)
+    if ( lazy && 0 == ::madvise( vp, size, MADV_FREE) ) {
+        return true;
+    }
+# else
+    (void)lazy;
+# endif
+# if defined(MADV_DONTNEED)
+    // eager release or MADV_FREE not supported by the kernel
+    return 0 == ::madvise( vp, size, MADV_DONTNEED);
+# else
+    return false;
+# endif
+#else
+    (void)bottom;
+    (void)top;
+    (void)watermark;
+    (void)lazy;
+    return false;
+#endif
+}
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,350 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/predef.h>
+
+#if BOOST_ARCH_X86
+# if BOOST_COMP_MSVC
+#  include <intrin.h>
+# else
+#  include <x86intrin.h>
+# endif
+#endif
+
+#include "boost/fiber/context.hpp"
+#include "boost/fiber/type.hpp"
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace {
+
+std::uint64_t timestamp() noexcept {
+#if BOOST_ARCH_X86
+    return static_cast< std::uint64_t >( __rdtsc() );
+#else
+    return static_cast< std::uint64_t >(
+            std::chrono::duration_cast< std::chrono::nanoseconds >(
+                std::chrono::steady_clock::now().time_since_epoch() ).count() );
+#endif
+}
+
+enum class context_kind : std::uint8_t {
+    worker = 0,
+    main,
+    dispatcher
+};
+
+struct record {
+    std::uint64_t   ts;
+    std::uintptr_t  ctx;
+    trace_event     event;
+    context_kind    kind;
+};
+
+// single-producer/single-consumer ring buffer
+// producer: the thread owning the buffer
+// consumer: write_chrome_trace() (serialized by the registry)
+class trace_buffer {
+private:
+    std::atomic< std::size_t >      head_{ 0 };
+    char                            pad_head_[cacheline_length];
+    std::atomic< std::size_t >      tail_{ 0 };
+    char                            pad_tail_[cacheline_length];
+    std::unique_ptr< record[] >     records_;
+
+public:
+    static constexpr std::size_t    capacity = BOOST_FIBERS_TRACE_BUFFER_SIZE;
+
+    const std::uint32_t             tid;
+    // written by the producer
+    std::atomic< std::uint64_t >    dropped{ 0 };
+    // consumer state, context of open_rec is running
+    bool                            open{ false };
+    record                          open_rec{};
+
+    explicit trace_buffer( std::uint32_t tid_) :
+        records_{ new record[capacity] },
+        tid{ tid_ } {
+        static_assert( 0 == ( capacity & ( capacity - 1) ), "BOOST_FIBERS_TRACE_BUFFER_SIZE must be a power of two");
+    }
+
+    trace_buffer( trace_buffer const&) = delete;
+    trace_buffer & operator=( trace_buffer const&) = delete;
+
+    bool push( record const& r) noexcept {
+        const std::size_t head = head_.load( std::memory_order_relaxed);
+        if ( head - tail_.load( std::memory_order_acquire) == capacity) {
+            // full, drop the event
+            dropped.fetch_add( 1, std::memory_order_relaxed);
+            return false;
+        }
+        records_[head & ( capacity - 1)] = r;
+        head_.store( head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop( record & r) noexcept {
+        const std::size_t tail = tail_.load( std::memory_order_relaxed);
+        if ( tail == head_.load( std::memory_order_acquire) ) {
+            return false;
+        }
+        r = records_[tail & ( capacity - 1)];
+        tail_.store( tail + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+constexpr std::size_t trace_buffer::capacity;
+
+struct registry {
+    std::mutex                                      mtx{};
+    std::vector< std::shared_ptr< trace_buffer > >  buffers{};
+    std::uint32_t                                   next_tid{ 1 };
+    // calibration of the timestamp counter
+    const std::uint64_t                             ts0{ timestamp() };
+    const std::chrono::steady_clock::time_point     tp0{ std::chrono::steady_clock::now() };
+};
+
+registry & get_registry() {
+    static registry r;
+    return r;
+}
+
+thread_local trace_buffer * local_buffer_{ nullptr };
+thread_local bool local_buffer_released_{ false };
+
+struct buffer_holder {
+    std::shared_ptr< trace_buffer >     buffer{};
+
+    ~buffer_holder() {
+        // the buffer is kept alive by the registry till it is drained
+        local_buffer_ = nullptr;
+        local_buffer_released_ = true;
+    }
+};
+
+trace_buffer * local_buffer() {
+    if ( BOOST_LIKELY( nullptr != local_buffer_) ) {
+        return local_buffer_;
+    }
+    if ( local_buffer_released_) {
+        // thread is terminating
+        return nullptr;
+    }
+    thread_local buffer_holder holder;
+    registry & r = get_registry();
+    std::unique_lock< std::mutex > lk{ r.mtx };
+    holder.buffer = std::make_shared< trace_buffer >( r.next_tid++);
+    r.buffers.push_back( holder.buffer);
+    local_buffer_ = holder.buffer.get();
+    return local_buffer_;
+}
+
+char const* event_name( trace_event ev) noexcept {
+    switch ( ev) {
+    case trace_event::spawn: return "spawn";
+    case trace_event::resume: return "resume";
+    case trace_event::suspend: return "suspend";
+    case trace_event::block: return "block";
+    case trace_event::wake: return "wake";
+    case trace_event::remote_wake: return "remote_wake";
+    case trace_event::steal: return "steal";
+    case trace_event::terminate: return "terminate";
+    case trace_event::park: return "park";
+    case trace_event::unpark: return "unpark";
+    }
+    return "unknown";
+}
+
+class chrome_writer {
+private:
+    std::ostream            &   os_;
+    std::uint64_t               ts0_;
+    double                      ticks_per_us_;
+    bool                        first_{ true };
+    std::ios_base::fmtflags     flags_;
+    std::streamsize             precision_;
+
+    void separator_() {
+        if ( ! first_) {
+            os_ << ",\n";
+        }
+        first_ = false;
+    }
+
+    double us_( std::uint64_t ts) const noexcept {
+        return ts > ts0_ ? static_cast< double >( ts - ts0_) / ticks_per_us_ : 0.;
+    }
+
+    void name_( record const& r) {
+        switch ( r.kind) {
+        case context_kind::main:
+            os_ << "main";
+            break;
+        case context_kind::dispatcher:
+            os_ << "dispatcher";
+            break;
+        default:
+            os_ << "fiber 0x" << std::hex << r.ctx << std::dec;
+            break;
+        }
+    }
+
+public:
+    chrome_writer( std::ostream & os, std::uint64_t ts0, double ticks_per_us) :
+        os_( os),
+        ts0_{ ts0 },
+        ticks_per_us_{ ticks_per_us },
+        flags_{ os.flags() },
+        precision_{ os.precision() } {
+        // timestamps in microseconds with nanosecond resolution; the default
+        // precision (6 significant digits) truncates after ~1s of tracing
+        os_ << std::fixed << std::setprecision( 3);
+    }
+
+    ~chrome_writer() {
+        os_.flags( flags_);
+        os_.precision( precision_);
+    }
+
+    chrome_writer( chrome_writer const&) = delete;
+    chrome_writer & operator=( chrome_writer const&) = delete;
+
+    void thread_name( std::uint32_t tid) {
+        separator_();
+        os_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"thread " << tid << "\"}}";
+    }
+
+    void slice( std::uint32_t tid, record const& from, std::uint64_t to) {
+        separator_();
+        os_ << "{\"name\":\"";
+        name_( from);
+        os_ << "\",\"cat\":\"fiber\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << us_( from.ts)
+            << ",\"dur\":" << ( us_( to) - us_( from.ts) ) << "}";
+    }
+
+    void instant( std::uint32_t tid, record const& r) {
+        separator_();
+        os_ << "{\"name\":\"" << event_name( r.event)
+            << "\",\"cat\":\"fiber\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << us_( r.ts);
+        if ( 0 != r.ctx) {
+            os_ << ",\"args\":{\"fiber\":\"";
+            name_( r);
+            os_ << "\"}";
+        }
+        os_ << "}";
+    }
+
+    void dropped( std::uint32_t tid, std::uint64_t count, std::uint64_t ts) {
+        separator_();
+        os_ << "{\"name\":\"dropped\",\"cat\":\"fiber\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << us_( ts)
+            << ",\"args\":{\"events\":" << count << "}}";
+    }
+};
+
+}
+
+namespace detail {
+
+void
+trace( trace_event ev, context const* ctx) noexcept {
+    trace_buffer * buffer = local_buffer();
+    if ( nullptr == buffer) {
+        return;
+    }
+    context_kind kind = context_kind::worker;
+    if ( nullptr != ctx) {
+        if ( ctx->is_context( type::main_context) ) {
+            kind = context_kind::main;
+        } else if ( ctx->is_context( type::dispatcher_context) ) {
+            kind = context_kind::dispatcher;
+        }
+    }
+    buffer->push( record{ timestamp(), reinterpret_cast< std::uintptr_t >( ctx), ev, kind });
+}
+
+}
+
+void
+write_chrome_trace( std::ostream & os) {
+    registry & r = get_registry();
+    // serializes consumers
+    std::unique_lock< std::mutex > lk{ r.mtx };
+    const std::uint64_t ts1 = timestamp();
+    const std::chrono::steady_clock::time_point tp1 = std::chrono::steady_clock::now();
+    const double us = static_cast< double >(
+            std::chrono::duration_cast< std::chrono::nanoseconds >( tp1 - r.tp0).count() ) / 1000.;
+    // ticks of the timestamp counter per microsecond
+    const double ticks_per_us = us > 0. && ts1 > r.ts0
+        ? static_cast< double >( ts1 - r.ts0) / us
+        : 1.;
+    chrome_writer writer{ os, r.ts0, ticks_per_us };
+    os << "{\"traceEvents\":[\n";
+    for ( std::shared_ptr< trace_buffer > const& buffer : r.buffers) {
+        writer.thread_name( buffer->tid);
+        record rec;
+        while ( buffer->pop( rec) ) {
+            switch ( rec.event) {
+            case trace_event::resume:
+                if ( buffer->open) {
+                    writer.slice( buffer->tid, buffer->open_rec, rec.ts);
+                }
+                buffer->open = true;
+                buffer->open_rec = rec;
+                break;
+            case trace_event::suspend:
+                if ( buffer->open && buffer->open_rec.ctx == rec.ctx) {
+                    writer.slice( buffer->tid, buffer->open_rec, rec.ts);
+                    buffer->open = false;
+                }
+                break;
+            default:
+                writer.instant( buffer->tid, rec);
+                break;
+            }
+        }
+        const std::uint64_t dropped = buffer->dropped.exchange( 0, std::memory_order_relaxed);
+        if ( 0 != dropped) {
+            writer.dropped( buffer->tid, dropped, ts1);
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    // buffers of terminated threads have been drained
+    std::vector< std::shared_ptr< trace_buffer > > alive;
+    for ( std::shared_ptr< trace_buffer > & buffer : r.buffers) {
+        if ( 1 < buffer.use_count() ) {
+            alive.push_back( std::move( buffer) );
+        }
+    }
+    r.buffers.swap( alive);
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,137 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/fiber/watchdog.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+#include <boost/assert.hpp>
+
+#include "boost/fiber/scheduler.hpp"
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace {
+
+// protects watchdog::entries_ and scheduler::watchdog_
+// shared by all watchdogs, so that a scheduler can detach
+// itself without knowing whether its watchdog is still alive
+std::mutex & registry_mtx() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+}
+
+void
+watchdog::run_() {
+    typedef std::tuple< context::id, std::thread::id, std::chrono::steady_clock::duration > report_t;
+    // poll twice per threshold
+    const std::chrono::steady_clock::duration interval = (std::max)(
+            std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                std::chrono::milliseconds( 1) ),
+            threshold_ / 2);
+    std::vector< report_t > reports;
+    std::unique_lock< std::mutex > lk{ mtx_ };
+    while ( ! stop_) {
+        cnd_.wait_for( lk, interval);
+        if ( stop_) {
+            break;
+        }
+        lk.unlock();
+        {
+            std::unique_lock< std::mutex > rlk{ registry_mtx() };
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            for ( entry & e : entries_) {
+                std::uint64_t seq = 0;
+                context * ctx = nullptr;
+                std::chrono::steady_clock::time_point since;
+                if ( ! e.sched->run_stamp_.read( seq, ctx, since) ||
+                     nullptr == ctx ||
+                     e.reported == seq) {
+                    continue;
+                }
+                if ( now - since >= threshold_) {
+                    // report only once per resumption
+                    e.reported = seq;
+                    reports.emplace_back( context::id{ ctx }, e.thread, now - since);
+                }
+            }
+        }
+        // the handler is called without holding a lock
+        for ( report_t const& r : reports) {
+            handler_( std::get< 0 >( r), std::get< 1 >( r), std::get< 2 >( r) );
+        }
+        reports.clear();
+        lk.lock();
+    }
+}
+
+void
+watchdog::detach_( scheduler * sched) noexcept {
+    std::unique_lock< std::mutex > lk{ registry_mtx() };
+    watchdog * w = sched->watchdog_;
+    if ( nullptr == w) {
+        return;
+    }
+    sched->watched_.store( false, std::memory_order_relaxed);
+    sched->watchdog_ = nullptr;
+    w->entries_.erase(
+        std::remove_if( w->entries_.begin(), w->entries_.end(),
+                        [sched]( entry const& e) { return sched == e.sched; }),
+        w->entries_.end() );
+}
+
+watchdog::watchdog( std::chrono::steady_clock::duration threshold, handler_type handler) :
+    threshold_{ threshold },
+    handler_( std::move( handler) ) {
+    BOOST_ASSERT( handler_);
+    thread_ = std::thread{ & watchdog::run_, this };
+}
+
+watchdog::~watchdog() {
+    {
+        std::unique_lock< std::mutex > lk{ mtx_ };
+        stop_ = true;
+    }
+    cnd_.notify_all();
+    thread_.join();
+    std::unique_lock< std::mutex > lk{ registry_mtx() };
+    for ( entry & e : entries_) {
+        e.sched->watched_.store( false, std::memory_order_relaxed);
+        e.sched->watchdog_ = nullptr;
+    }
+    entries_.clear();
+}
+
+void
+watchdog::watch() {
+    context * active_ctx = context::active();
+    scheduler * sched = active_ctx->get_scheduler();
+    detach_( sched);
+    std::unique_lock< std::mutex > lk{ registry_mtx() };
+    entries_.push_back( entry{ sched, std::this_thread::get_id(), 0 });
+    sched->watchdog_ = this;
+    // the active context is running since now
+    sched->run_stamp_.stamp( active_ctx->is_context( type::dispatcher_context) ? nullptr : active_ctx);
+    sched->watched_.store( true, std::memory_order_relaxed);
+}
+
+void
+watchdog::unwatch() noexcept {
+    detach_( context::active()->get_scheduler() );
+}
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
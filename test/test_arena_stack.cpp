@@ -0,0 +1,152 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+typedef boost::fibers::arena_fixedsize_stack    allocator_type;
+
+void test_carve() {
+    allocator_type salloc{ 64 * 1024, 0, 4 };
+    std::vector< boost::context::stack_context > stacks;
+    for ( int i = 0; i < 4; ++i) {
+        boost::context::stack_context sctx = salloc.allocate();
+        BOOST_CHECK( nullptr != sctx.sp);
+        BOOST_CHECK_EQUAL( std::size_t( 64 * 1024), sctx.size);
+        // the whole stack is usable
+        static_cast< char * >( sctx.sp)[-1] = 1;
+        ( static_cast< char * >( sctx.sp) - sctx.size)[0] = 1;
+        stacks.push_back( sctx);
+    }
+    // adjacent slots of one chunk
+    BOOST_CHECK_EQUAL( std::size_t( 1), salloc.chunk_count() );
+    for ( std::size_t i = 1; i < stacks.size(); ++i) {
+        BOOST_CHECK_EQUAL( static_cast< char * >( stacks[i - 1].sp) + 64 * 1024,
+                           static_cast< char * >( stacks[i].sp) );
+    }
+    for ( auto & sctx : stacks) {
+        salloc.deallocate( sctx);
+    }
+}
+
+void test_reuse() {
+    allocator_type salloc{ 64 * 1024 };
+    boost::context::stack_context sctx1 = salloc.allocate();
+    boost::context::stack_context sctx2 = salloc.allocate();
+    salloc.deallocate( sctx1);
+    salloc.deallocate( sctx2);
+    // LIFO
+    boost::context::stack_context sctx3 = salloc.allocate();
+    BOOST_CHECK_EQUAL( sctx2.sp, sctx3.sp);
+    boost::context::stack_context sctx4 = salloc.allocate();
+    BOOST_CHECK_EQUAL( sctx1.sp, sctx4.sp);
+    salloc.deallocate( sctx3);
+    salloc.deallocate( sctx4);
+}
+
+void test_chunks() {
+    // without huge pages a chunk holds exactly 2 slots
+    allocator_type salloc{ 64 * 1024, 0, 2, boost::fibers::huge_page_policy::none };
+    std::set< void * > sps;
+    std::vector< boost::context::stack_context > stacks;
+    for ( int i = 0; i < 5; ++i) {
+        stacks.push_back( salloc.allocate() );
+        sps.insert( stacks.back().sp);
+    }
+    BOOST_CHECK_EQUAL( std::size_t( 5), sps.size() );
+    BOOST_CHECK_EQUAL( std::size_t( 3), salloc.chunk_count() );
+    BOOST_CHECK_EQUAL( std::size_t( 0), salloc.huge_chunk_count() );
+    for ( auto & sctx : stacks) {
+        salloc.deallocate( sctx);
+    }
+}
+
+void test_huge_pages() {
+    allocator_type salloc{ 64 * 1024, 0, 4, boost::fibers::huge_page_policy::transparent };
+    boost::context::stack_context sctx = salloc.allocate();
+    const std::size_t huge_size = boost::fibers::detail::huge_page_size();
+    if ( 0 != huge_size) {
+        // chunks are aligned to the huge page size
+        char * chunk = static_cast< char * >( sctx.sp) - sctx.size;
+        BOOST_CHECK_EQUAL( std::uintptr_t( 0), reinterpret_cast< std::uintptr_t >( chunk) % huge_size);
+    }
+    salloc.deallocate( sctx);
+}
+
+void test_guard() {
+    const std::size_t page_size = boost::context::stack_traits::page_size();
+    allocator_type salloc{ 64 * 1024, page_size, 4, boost::fibers::huge_page_policy::none };
+    boost::context::stack_context sctx1 = salloc.allocate();
+    boost::context::stack_context sctx2 = salloc.allocate();
+    BOOST_CHECK_EQUAL( std::size_t( 64 * 1024), sctx1.size);
+    // the guard gap separates adjacent stacks
+    BOOST_CHECK_EQUAL( static_cast< char * >( sctx1.sp) + 64 * 1024 + page_size,
+                       static_cast< char * >( sctx2.sp) );
+    salloc.deallocate( sctx1);
+    salloc.deallocate( sctx2);
+}
+
+void test_guard_disables_huge_pages() {
+    const std::size_t page_size = boost::context::stack_traits::page_size();
+    allocator_type salloc{ 64 * 1024, page_size, 4, boost::fibers::huge_page_policy::transparent };
+    boost::context::stack_context sctx = salloc.allocate();
+    BOOST_CHECK_EQUAL( std::size_t( 1), salloc.chunk_count() );
+    // the guard gaps would split the huge pages
+    BOOST_CHECK_EQUAL( std::size_t( 0), salloc.huge_chunk_count() );
+    salloc.deallocate( sctx);
+}
+
+void test_fibers() {
+    allocator_type salloc{ 64 * 1024, boost::context::stack_traits::page_size() };
+    int count = 0;
+    std::vector< boost::fibers::fiber > fibers;
+    for ( int i = 0; i < 10; ++i) {
+        fibers.emplace_back( std::allocator_arg, salloc, [&count](){
+            boost::this_fiber::yield();
+            ++count;
+        });
+    }
+    for ( auto & f : fibers) {
+        f.join();
+    }
+    BOOST_CHECK_EQUAL( 10, count);
+}
+
+void test_cross_thread() {
+    allocator_type salloc{ 64 * 1024 };
+    boost::context::stack_context sctx1 = salloc.allocate();
+    std::thread t( [&salloc,&sctx1](){
+        salloc.deallocate( sctx1);
+    });
+    t.join();
+    // the free list is shared by all threads
+    boost::context::stack_context sctx2 = salloc.allocate();
+    BOOST_CHECK_EQUAL( sctx1.sp, sctx2.sp);
+    salloc.deallocate( sctx2);
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: arena stack allocator test suite");
+
+    test->add( BOOST_TEST_CASE( & test_carve) );
+    test->add( BOOST_TEST_CASE( & test_reuse) );
+    test->add( BOOST_TEST_CASE( & test_chunks) );
+    test->add( BOOST_TEST_CASE( & test_huge_pages) );
+    test->add( BOOST_TEST_CASE( & test_guard) );
+    test->add( BOOST_TEST_CASE( & test_guard_disables_huge_pages) );
+    test->add( BOOST_TEST_CASE( & test_fibers) );
+    test->add( BOOST_TEST_CASE( & test_cross_thread) );
+
+    return test;
+}
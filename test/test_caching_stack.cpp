@@ -0,0 +1,184 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/predef.h>
+
+#include <boost/fiber/all.hpp>
+
+#if defined(BOOST_OS_LINUX) && BOOST_OS_LINUX
+extern "C" {
+#include <sys/mman.h>
+#include <unistd.h>
+}
+
+// page of vp is backed by physical memory
+bool resident( void * vp) {
+    const std::uintptr_t page_size = ::sysconf( _SC_PAGESIZE);
+    void * page = reinterpret_cast< void * >( reinterpret_cast< std::uintptr_t >( vp) & ~ ( page_size - 1) );
+    unsigned char vec = 0;
+    BOOST_REQUIRE( 0 == ::mincore( page, page_size, & vec) );
+    return 0 != ( vec & 1);
+}
+#endif
+
+typedef boost::fibers::caching_fixedsize_stack  allocator_type;
+
+void test_reuse() {
+    allocator_type salloc{ 64 * 1024 };
+    boost::context::stack_context sctx1 = salloc.allocate();
+    BOOST_CHECK( nullptr != sctx1.sp);
+    BOOST_CHECK_EQUAL( std::size_t( 64 * 1024), sctx1.size);
+    salloc.deallocate( sctx1);
+    // taken from the cache of this thread
+    boost::context::stack_context sctx2 = salloc.allocate();
+    BOOST_CHECK_EQUAL( sctx1.sp, sctx2.sp);
+    salloc.deallocate( sctx2);
+}
+
+void test_cross_thread() {
+    allocator_type salloc{ 64 * 1024 };
+    boost::context::stack_context sctx1 = salloc.allocate();
+    std::thread t1( [&salloc,&sctx1](){
+        // cached by t1, moved to the depot if t1 terminates
+        salloc.deallocate( sctx1);
+    });
+    t1.join();
+    std::thread t2( [&salloc,&sctx1](){
+        // batch taken from the depot
+        boost::context::stack_context sctx = salloc.allocate();
+        BOOST_CHECK_EQUAL( sctx1.sp, sctx.sp);
+        salloc.deallocate( sctx);
+    });
+    t2.join();
+}
+
+void test_bounded_cache() {
+    // at most 4 stacks per thread, the depot holds one batch
+    allocator_type salloc{ 64 * 1024, 4, 1 };
+    std::vector< boost::context::stack_context > stacks;
+    for ( int i = 0; i < 5; ++i) {
+        stacks.push_back( salloc.allocate() );
+    }
+    std::thread t( [&salloc,&stacks](){
+        // the 5th stack exceeds the cache, 3 stacks are moved to the depot
+        for ( auto & sctx : stacks) {
+            salloc.deallocate( sctx);
+        }
+        std::set< void * > sps;
+        for ( auto & sctx : stacks) {
+            sps.insert( sctx.sp);
+        }
+        // 2 stacks cached, 3 taken from the depot
+        for ( int i = 0; i < 5; ++i) {
+            boost::context::stack_context sctx = salloc.allocate();
+            BOOST_CHECK( 0 != sps.count( sctx.sp) );
+            stacks[i] = sctx;
+        }
+        for ( auto & sctx : stacks) {
+            salloc.deallocate( sctx);
+        }
+    });
+    t.join();
+}
+
+void test_fibers() {
+    allocator_type salloc{ 64 * 1024 };
+    int count = 0;
+    for ( int i = 0; i < 10; ++i) {
+        boost::fibers::fiber{ std::allocator_arg, salloc, [&count](){ ++count; } }.join();
+    }
+    BOOST_CHECK_EQUAL( 10, count);
+}
+
+void test_release() {
+    boost::fibers::stack_release_policy release;
+    release.enabled = true;
+    release.watermark = 4 * 1024;
+    release.hysteresis = 1;
+    release.lazy = false;
+    allocator_type salloc{ 64 * 1024, 16, 64, release };
+    std::vector< boost::context::stack_context > stacks;
+    std::vector< char * > cold;
+    for ( int i = 0; i < 3; ++i) {
+        boost::context::stack_context sctx = salloc.allocate();
+        // within the watermark, kept resident
+        static_cast< char * >( sctx.sp)[-64] = 1;
+        // below the watermark, released
+        static_cast< char * >( sctx.sp)[- 32 * 1024] = 1;
+        stacks.push_back( sctx);
+        cold.push_back( static_cast< char * >( sctx.sp) - 32 * 1024);
+    }
+    // all but the most recently returned stack are released
+    for ( auto & sctx : stacks) {
+        salloc.deallocate( sctx);
+    }
+#if defined(BOOST_OS_LINUX) && BOOST_OS_LINUX
+    BOOST_CHECK( ! resident( cold[0]) );
+    BOOST_CHECK( resident( static_cast< char * >( stacks[0].sp) - 64) );
+    BOOST_CHECK( resident( cold[2]) );
+#endif
+    for ( auto & sctx : stacks) {
+        sctx = salloc.allocate();
+        BOOST_CHECK_EQUAL( 1, static_cast< char * >( sctx.sp)[-64]);
+        // released pages are usable again
+        static_cast< char * >( sctx.sp)[- 32 * 1024] = 1;
+    }
+    for ( auto & sctx : stacks) {
+        salloc.deallocate( sctx);
+    }
+    int count = 0;
+    for ( int i = 0; i < 10; ++i) {
+        boost::fibers::fiber{ std::allocator_arg, salloc, [&count](){ ++count; } }.join();
+    }
+    BOOST_CHECK_EQUAL( 10, count);
+}
+
+void test_release_stack_memory() {
+#if defined(BOOST_OS_LINUX) && BOOST_OS_LINUX
+    const std::size_t size = 64 * 1024;
+    void * vp = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    BOOST_REQUIRE( MAP_FAILED != vp);
+    char * bottom = static_cast< char * >( vp);
+    char * top = bottom + size;
+    for ( char * p = bottom; p < top; p += 512) {
+        * p = 1;
+    }
+    // the range is within the watermark, nothing to release
+    BOOST_CHECK( boost::fibers::detail::release_stack_memory( top - 8 * 1024, top, 16 * 1024, false) );
+    BOOST_CHECK( resident( top - 8 * 1024) );
+    // pages below the watermark are no longer resident,
+    // the pages of the watermark are kept
+    BOOST_CHECK( boost::fibers::detail::release_stack_memory( bottom, top, 16 * 1024, false) );
+    BOOST_CHECK( ! resident( bottom) );
+    BOOST_CHECK( ! resident( top - 32 * 1024) );
+    BOOST_CHECK( resident( top - 1024) );
+    // released pages are zero-filled on the next access
+    BOOST_CHECK_EQUAL( 0, bottom[0]);
+    ::munmap( vp, size);
+#endif
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: caching stack allocator test suite");
+
+    test->add( BOOST_TEST_CASE( & test_reuse) );
+    test->add( BOOST_TEST_CASE( & test_cross_thread) );
+    test->add( BOOST_TEST_CASE( & test_bounded_cache) );
+    test->add( BOOST_TEST_CASE( & test_fibers) );
+    test->add( BOOST_TEST_CASE( & test_release) );
+    test->add( BOOST_TEST_CASE( & test_release_stack_memory) );
+
+    return test;
+}
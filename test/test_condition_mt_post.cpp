@@ -12,6 +12,7 @@
 #include <map>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 #include <boost/atomic.hpp>
@@ -145,6 +146,27 @@ void test_two_waiter_notify_all() {
     }
 }
 
+void test_wakeup_racing_scheduler_destruction() {
+    // the main-context of a thread is woken from another thread and
+    // the thread terminates (destroying its scheduler) at once, while
+    // the waking thread might still be inside schedule_from_remote()
+    for ( int i = 0; i < 500; ++i) {
+        boost::fibers::mutex mtx;
+        boost::fibers::condition_variable cond;
+        bool ready = false;
+        std::thread waiter( [&mtx,&cond,&ready](){
+            std::unique_lock< boost::fibers::mutex > lk( mtx);
+            cond.wait( lk, [&ready](){ return ready; });
+        });
+        {
+            std::unique_lock< boost::fibers::mutex > lk( mtx);
+            ready = true;
+        }
+        cond.notify_one();
+        waiter.join();
+    }
+}
+
 void test_dummy() {
 }
 
@@ -156,6 +178,7 @@ boost::unit_test::test_suite * init_unit_test_suite( int, char* [])
 #if ! defined(BOOST_FIBERS_NO_ATOMICS)
     test->add( BOOST_TEST_CASE( & test_one_waiter_notify_one) );
     test->add( BOOST_TEST_CASE( & test_two_waiter_notify_all) );
+    test->add( BOOST_TEST_CASE( & test_wakeup_racing_scheduler_destruction) );
 #else
     test->add( BOOST_TEST_CASE( & test_dummy) );
 #endif
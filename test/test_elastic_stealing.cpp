@@ -0,0 +1,156 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+typedef boost::fibers::algo::stealing_domain    domain_type;
+typedef boost::fibers::algo::work_stealing      algo_type;
+
+boost::intrusive_ptr< algo_type > install( std::shared_ptr< domain_type > domain) {
+    boost::intrusive_ptr< algo_type > algo{ new algo_type{ domain } };
+    boost::fibers::context::active()->get_scheduler()->set_algo( algo);
+    return algo;
+}
+
+void test_live_slots() {
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 2);
+    BOOST_CHECK_EQUAL( std::uint32_t( 0), d->live_count() );
+    std::thread t( [d](){
+        boost::intrusive_ptr< algo_type > algo = install( d);
+        BOOST_CHECK_EQUAL( std::uint32_t( 1), d->live_count() );
+        algo->retire();
+        BOOST_CHECK( algo->is_retiring() );
+        BOOST_CHECK_EQUAL( std::uint32_t( 0), d->live_count() );
+        // a retired scheduler still runs its own fibers
+        int i = 0;
+        boost::fibers::fiber( [&i](){ ++i; }).join();
+        BOOST_CHECK_EQUAL( 1, i);
+    });
+    t.join();
+    BOOST_CHECK_EQUAL( std::uint32_t( 0), d->live_count() );
+}
+
+void test_slot_reuse() {
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 1);
+    for ( int i = 0; i < 3; ++i) {
+        // slot is released if the thread terminates
+        std::thread t( [d](){
+            install( d);
+            boost::fibers::fiber( [](){ boost::this_fiber::yield(); }).join();
+        });
+        t.join();
+    }
+    BOOST_CHECK_EQUAL( std::uint32_t( 0), d->live_count() );
+}
+
+void test_migration() {
+    const int n = 50;
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 2);
+    std::atomic< bool > joined{ false };
+    std::atomic< bool > stop{ false };
+    std::atomic< int > done{ 0 };
+    std::mutex mtx{};
+    std::set< std::thread::id > seen{};
+    std::thread::id peer_id{};
+    // scheduler joining the domain
+    std::thread peer( [d,&joined,&stop,&peer_id](){
+        install( d);
+        peer_id = std::this_thread::get_id();
+        joined = true;
+        while ( ! stop) {
+            boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+        }
+    });
+    while ( ! joined) {
+        std::this_thread::yield();
+    }
+    // scheduler leaving the domain
+    std::thread retiring( [d,&done,&mtx,&seen](){
+        boost::intrusive_ptr< algo_type > algo = install( d);
+        for ( int i = 0; i < n; ++i) {
+            boost::fibers::fiber( [&done,&mtx,&seen](){
+                {
+                    std::unique_lock< std::mutex > lk{ mtx };
+                    seen.insert( std::this_thread::get_id() );
+                }
+                ++done;
+            }).detach();
+        }
+        // the fibers have not been resumed yet
+        algo->retire();
+        while ( n != done) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1) );
+        }
+    });
+    retiring.join();
+    stop = true;
+    peer.join();
+    BOOST_CHECK_EQUAL( n, done.load() );
+    // all fibers have been migrated to the live scheduler
+    BOOST_CHECK_EQUAL( std::size_t( 1), seen.size() );
+    BOOST_CHECK( 0 != seen.count( peer_id) );
+}
+
+void test_retired_parks() {
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 2);
+    std::atomic< bool > joined{ false };
+    std::atomic< bool > stop{ false };
+    // live scheduler whose ready-queue is never empty
+    std::thread peer( [d,&joined,&stop](){
+        algo_type * algo = new algo_type{ d, true };
+        boost::fibers::context::active()->get_scheduler()->set_algo( algo);
+        boost::fibers::fiber f1( [&stop](){
+            while ( ! stop) {
+                boost::this_fiber::yield();
+            }
+        });
+        boost::fibers::fiber f2( [&stop](){
+            while ( ! stop) {
+                boost::this_fiber::yield();
+            }
+        });
+        joined = true;
+        f1.join();
+        f2.join();
+    });
+    while ( ! joined) {
+        std::this_thread::yield();
+    }
+    std::thread retired( [d](){
+        algo_type * algo = new algo_type{ d, true };
+        boost::fibers::context::active()->get_scheduler()->set_algo( algo);
+        algo->retire();
+        const std::uint64_t parks = boost::fibers::get_statistics().parks;
+        // the retired scheduler does not run the ready fibers of the
+        // live scheduler, it must park instead of spinning
+        boost::this_fiber::sleep_for( std::chrono::milliseconds( 50) );
+        BOOST_CHECK( boost::fibers::get_statistics().parks - parks < 10);
+    });
+    retired.join();
+    stop = true;
+    peer.join();
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: elastic work-stealing test suite");
+
+    test->add( BOOST_TEST_CASE( & test_live_slots) );
+    test->add( BOOST_TEST_CASE( & test_slot_reuse) );
+    test->add( BOOST_TEST_CASE( & test_migration) );
+    test->add( BOOST_TEST_CASE( & test_retired_parks) );
+
+    return test;
+}
@@ -6,7 +6,9 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -222,6 +224,59 @@ void test_fss_at_the_same_adress() {
     boost::fibers::fiber( boost::fibers::launch::dispatch, fss_at_the_same_adress).join();
 }
 
+
+void fss_overflow() {
+    // more fiber_specific_ptrs than values stored inline
+    std::vector< std::unique_ptr< boost::fibers::fiber_specific_ptr< int > > > ptrs;
+    for ( int i = 0; i < 3 * BOOST_FIBERS_FSS_INLINE_SIZE; ++i) {
+        ptrs.emplace_back( new boost::fibers::fiber_specific_ptr< int >() );
+    }
+    for ( std::size_t i = 0; i < ptrs.size(); ++i) {
+        BOOST_CHECK( nullptr == ptrs[i]->get() );
+        ptrs[i]->reset( new int( static_cast< int >( i) ) );
+    }
+    boost::fibers::fiber( boost::fibers::launch::dispatch, [&ptrs](){
+        // values are fiber-specific
+        for ( auto & p : ptrs) {
+            BOOST_CHECK( nullptr == p->get() );
+        }
+        ptrs.back()->reset( new int( -1) );
+        BOOST_CHECK_EQUAL( -1, * ptrs.back()->get() );
+    }).join();
+    for ( std::size_t i = 0; i < ptrs.size(); ++i) {
+        BOOST_CHECK_EQUAL( static_cast< int >( i), * ptrs[i]->get() );
+    }
+}
+
+void test_fss_overflow() {
+    boost::fibers::fiber( boost::fibers::launch::dispatch, fss_overflow).join();
+}
+
+
+void fss_reused_index() {
+    std::unique_ptr< boost::fibers::fiber_specific_ptr< Dummy > > fss1{
+        new boost::fibers::fiber_specific_ptr< Dummy >( fss_custom_cleanup) };
+    fss1->reset( new Dummy);
+    // destroyed by another fiber, the value of this fiber is left
+    boost::fibers::fiber( boost::fibers::launch::dispatch, [&fss1](){ fss1.reset(); }).join();
+    fss_cleanup_called = false;
+    // might reuse the index of fss1
+    boost::fibers::fiber_specific_ptr< Dummy > fss2( fss_custom_cleanup);
+    BOOST_CHECK( nullptr == fss2.get() );
+    // the left value is cleaned up (LIFO reuse of indices)
+    fss2.reset( new Dummy);
+    BOOST_CHECK( fss_cleanup_called);
+    BOOST_CHECK( nullptr != fss2.get() );
+    fss_cleanup_called = false;
+    fss2.reset( nullptr);
+    BOOST_CHECK( fss_cleanup_called);
+    fss_cleanup_called = false;
+}
+
+void test_fss_reused_index() {
+    boost::fibers::fiber( boost::fibers::launch::dispatch, fss_reused_index).join();
+}
+
 boost::unit_test::test_suite* init_unit_test_suite(int, char*[]) {
     boost::unit_test::test_suite* test =
         BOOST_TEST_SUITE("Boost.Fiber: fss test suite");
@@ -232,6 +287,8 @@ boost::unit_test::test_suite* init_unit_test_suite(int, char*[]) {
     test->add(BOOST_TEST_CASE(test_fss_does_no_cleanup_with_null_cleanup_function));
     test->add(BOOST_TEST_CASE(test_fss_does_not_call_cleanup_after_ptr_destroyed));
     test->add(BOOST_TEST_CASE(test_fss_cleanup_not_called_for_null_pointer));
+    test->add(BOOST_TEST_CASE(test_fss_overflow));
+    test->add(BOOST_TEST_CASE(test_fss_reused_index));
 
     return test;
 }
@@ -0,0 +1,240 @@
+
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/predef.h>
+
+#include <boost/fiber/all.hpp>
+
+#if defined(BOOST_OS_LINUX) && BOOST_OS_LINUX
+extern "C" {
+#include <sys/mman.h>
+#include <unistd.h>
+}
+
+// page of vp is backed by physical memory
+bool resident( void * vp) {
+    const std::uintptr_t page_size = ::sysconf( _SC_PAGESIZE);
+    void * page = reinterpret_cast< void * >( reinterpret_cast< std::uintptr_t >( vp) & ~ ( page_size - 1) );
+    unsigned char vec = 0;
+    BOOST_REQUIRE( 0 == ::mincore( page, page_size, & vec) );
+    return 0 != ( vec & 1);
+}
+#endif
+
+typedef boost::fibers::numa::pooled_fixedsize_stack    allocator_type;
+
+std::vector< boost::fibers::numa::node > two_nodes() {
+    std::vector< boost::fibers::numa::node > topo( 2);
+    topo[0].id = 0;
+    topo[1].id = 1;
+    return topo;
+}
+
+void test_current_node() {
+    std::thread t( [](){
+        boost::fibers::numa::set_current_node( 1);
+        BOOST_CHECK_EQUAL( std::uint32_t( 1), boost::fibers::numa::current_node() );
+    });
+    t.join();
+}
+
+void test_reuse() {
+    allocator_type salloc{ two_nodes(), 64 * 1024 };
+    boost::context::stack_context sctx1 = salloc.allocate();
+    BOOST_CHECK( nullptr != sctx1.sp);
+    BOOST_CHECK( 64 * 1024 > sctx1.size);
+    salloc.deallocate( sctx1);
+    // taken from the free list
+    boost::context::stack_context sctx2 = salloc.allocate();
+    BOOST_CHECK_EQUAL( sctx1.sp, sctx2.sp);
+    salloc.deallocate( sctx2);
+}
+
+void test_node_free_lists() {
+    allocator_type salloc{ two_nodes(), 64 * 1024 };
+    boost::context::stack_context sctx1;
+    std::thread t1( [&salloc,&sctx1](){
+        boost::fibers::numa::set_current_node( 1);
+        sctx1 = salloc.allocate();
+    });
+    t1.join();
+    std::thread t0( [&salloc,&sctx1](){
+        boost::fibers::numa::set_current_node( 0);
+        // returned to the free list of node 1
+        salloc.deallocate( sctx1);
+        boost::context::stack_context sctx = salloc.allocate();
+        BOOST_CHECK( sctx1.sp != sctx.sp);
+        salloc.deallocate( sctx);
+    });
+    t0.join();
+    std::thread t2( [&salloc,&sctx1](){
+        boost::fibers::numa::set_current_node( 1);
+        boost::context::stack_context sctx = salloc.allocate();
+        BOOST_CHECK_EQUAL( sctx1.sp, sctx.sp);
+        salloc.deallocate( sctx);
+    });
+    t2.join();
+}
+
+void test_fibers() {
+    allocator_type salloc{ boost::fibers::numa::topology(), 64 * 1024 };
+    int count = 0;
+    for ( int i = 0; i < 10; ++i) {
+        boost::fibers::fiber{ std::allocator_arg, salloc, [&count](){ ++count; } }.join();
+    }
+    BOOST_CHECK_EQUAL( 10, count);
+}
+
+void test_release() {
+    boost::fibers::stack_release_policy release;
+    release.enabled = true;
+    release.watermark = 4 * 1024;
+    release.hysteresis = 1;
+    release.lazy = false;
+    allocator_type salloc{ two_nodes(), 64 * 1024, 64, release };
+    std::vector< boost::context::stack_context > stacks;
+    for ( int i = 0; i < 3; ++i) {
+        boost::context::stack_context sctx = salloc.allocate();
+        // within the watermark, kept resident
+        static_cast< char * >( sctx.sp)[-64] = 1;
+        // below the watermark, released
+        static_cast< char * >( sctx.sp)[- 32 * 1024] = 1;
+        stacks.push_back( sctx);
+    }
+    // all but the most recently returned stack are released
+    for ( auto & sctx : stacks) {
+        salloc.deallocate( sctx);
+    }
+#if defined(BOOST_OS_LINUX) && BOOST_OS_LINUX
+    BOOST_CHECK( ! resident( static_cast< char * >( stacks[0].sp) - 32 * 1024) );
+    BOOST_CHECK( resident( static_cast< char * >( stacks[0].sp) - 64) );
+    BOOST_CHECK( resident( static_cast< char * >( stacks[2].sp) - 32 * 1024) );
+#endif
+    for ( auto & sctx : stacks) {
+        sctx = salloc.allocate();
+        BOOST_CHECK_EQUAL( 1, static_cast< char * >( sctx.sp)[-64]);
+        // released pages are usable again
+        static_cast< char * >( sctx.sp)[- 32 * 1024] = 1;
+    }
+    for ( auto & sctx : stacks) {
+        salloc.deallocate( sctx);
+    }
+}
+
+void test_stack_bounds() {
+    allocator_type salloc{ two_nodes(), 64 * 1024 };
+    boost::fibers::fiber{ std::allocator_arg, salloc, [](){
+        boost::fibers::context * active = boost::fibers::context::active();
+        char * bottom = static_cast< char * >( active->get_stack_bottom() );
+        char * top = static_cast< char * >( active->get_stack_top() );
+        char c = 0;
+        BOOST_CHECK( bottom < & c);
+        BOOST_CHECK( & c < top);
+        BOOST_CHECK( reinterpret_cast< char * >( active) < top);
+    } }.join();
+    // main-context has no stack of its own
+    BOOST_CHECK( nullptr == boost::fibers::context::active()->get_stack_top() );
+}
+
+void test_migrate_counts_moved_pages() {
+    std::vector< char > buffer( 16 * 4096, 'a');
+    const std::uint32_t node_id = boost::fibers::numa::memory_node( buffer.data() );
+    if ( boost::fibers::numa::unknown_node == node_id) {
+        return;
+    }
+    // the pages are already located on node_id
+    BOOST_CHECK_EQUAL( std::size_t( 0),
+                       boost::fibers::numa::migrate_memory( buffer.data(), buffer.size(), node_id) );
+}
+
+void test_allocate_unbound() {
+#if defined(BOOST_OS_LINUX) && BOOST_OS_LINUX
+    const std::size_t size = 64 * 1024;
+    // binding to an invalid node fails, first-touch policy
+    const std::uint32_t node_id = 1024 * 1024;
+    BOOST_CHECK( ! boost::fibers::numa::bind_memory( nullptr, size, node_id) );
+    char * vp = static_cast< char * >( boost::fibers::numa::allocate_memory( size, node_id) );
+    // only the top page has been touched
+    BOOST_CHECK( resident( vp + size - 1) );
+    BOOST_CHECK( ! resident( vp) );
+    BOOST_CHECK( ! resident( vp + size / 2) );
+    boost::fibers::numa::deallocate_memory( vp, size);
+#endif
+}
+
+void test_track_node() {
+    std::thread t( [](){
+        std::vector< boost::fibers::numa::node > topo = boost::fibers::numa::topology();
+        const std::uint32_t node_id = topo[0].id;
+        const std::uint32_t cpu_id = * topo[0].logical_cpus.begin();
+        auto domain = std::make_shared< boost::fibers::algo::stealing_domain >(
+                boost::fibers::algo::numa::work_stealing::domain_size( topo) );
+        boost::fibers::algo::numa::memory_migration migration;
+        migration.enabled = true;
+        migration.threshold = 2;
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::numa::work_stealing >(
+                cpu_id, node_id, topo, domain, migration);
+        boost::fibers::fiber( [node_id](){
+            boost::fibers::context * ctx = boost::fibers::context::active();
+            // home node is the node announced by the creating thread
+            BOOST_CHECK_EQUAL( node_id, ctx->numa_node);
+            const std::uint32_t remote_id = node_id + 1;
+            const std::uint64_t migrations = boost::fibers::get_statistics().stack_migrations;
+            // stack pretended to be located on a remote node
+            ctx->numa_node = remote_id;
+            boost::this_fiber::yield();
+            BOOST_CHECK_EQUAL( remote_id, ctx->numa_node);
+            BOOST_CHECK_EQUAL( std::uint32_t( 1), ctx->numa_remote_picks);
+            BOOST_CHECK_EQUAL( migrations, boost::fibers::get_statistics().stack_migrations);
+            // threshold reached, the pages are already located on the
+            // local node: the fiber becomes local, nothing is counted
+            boost::this_fiber::yield();
+            if ( boost::fibers::numa::unknown_node != boost::fibers::numa::memory_node( ctx) ) {
+                BOOST_CHECK_EQUAL( node_id, ctx->numa_node);
+            }
+            BOOST_CHECK_EQUAL( std::uint32_t( 0), ctx->numa_remote_picks);
+            BOOST_CHECK_EQUAL( migrations, boost::fibers::get_statistics().stack_migrations);
+            // a pick on the home node resets the count
+            ctx->numa_node = remote_id;
+            boost::this_fiber::yield();
+            BOOST_CHECK_EQUAL( std::uint32_t( 1), ctx->numa_remote_picks);
+            ctx->numa_node = node_id;
+            boost::this_fiber::yield();
+            BOOST_CHECK_EQUAL( std::uint32_t( 0), ctx->numa_remote_picks);
+            ctx->numa_node = remote_id;
+            boost::this_fiber::yield();
+            BOOST_CHECK_EQUAL( std::uint32_t( 1), ctx->numa_remote_picks);
+            BOOST_CHECK_EQUAL( migrations, boost::fibers::get_statistics().stack_migrations);
+            ctx->numa_node = node_id;
+        }).join();
+    });
+    t.join();
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: numa stack allocator test suite");
+
+    test->add( BOOST_TEST_CASE( & test_current_node) );
+    test->add( BOOST_TEST_CASE( & test_reuse) );
+    test->add( BOOST_TEST_CASE( & test_node_free_lists) );
+    test->add( BOOST_TEST_CASE( & test_fibers) );
+    test->add( BOOST_TEST_CASE( & test_release) );
+    test->add( BOOST_TEST_CASE( & test_stack_bounds) );
+    test->add( BOOST_TEST_CASE( & test_migrate_counts_moved_pages) );
+    test->add( BOOST_TEST_CASE( & test_allocate_unbound) );
+    test->add( BOOST_TEST_CASE( & test_track_node) );
+
+    return test;
+}
@@ -0,0 +1,107 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+void test_post() {
+    std::atomic< int > count{ 0 };
+    {
+        boost::fibers::pool p{ 2, boost::fibers::pool::algorithm< boost::fibers::algo::round_robin >() };
+        BOOST_CHECK_EQUAL( std::uint32_t( 2), p.thread_count() );
+        for ( int i = 0; i < 100; ++i) {
+            p.post( [&count]( int n){
+                boost::this_fiber::yield();
+                count += n;
+            }, 1);
+        }
+        // drains the queue
+        p.shutdown();
+        BOOST_CHECK_EQUAL( 100, count.load() );
+    }
+}
+
+void test_submit() {
+    boost::fibers::pool p{ 2, boost::fibers::pool::algorithm< boost::fibers::algo::shared_work >() };
+    std::vector< boost::fibers::future< int > > results;
+    for ( int i = 0; i < 10; ++i) {
+        results.push_back( p.submit( []( int n){
+            boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+            return 2 * n;
+        }, i) );
+    }
+    int sum = 0;
+    for ( boost::fibers::future< int > & f : results) {
+        sum += f.get();
+    }
+    BOOST_CHECK_EQUAL( 90, sum);
+    boost::fibers::future< int > f = p.submit( [](){
+        throw std::runtime_error("abc");
+        return 0;
+    });
+    BOOST_CHECK_THROW( f.get(), std::runtime_error);
+}
+
+void test_move_only() {
+    boost::fibers::pool p{ 1, boost::fibers::pool::algorithm< boost::fibers::algo::round_robin >() };
+    std::unique_ptr< int > v{ new int( 7) };
+    boost::fibers::future< int > f = p.submit( []( std::unique_ptr< int > v){
+        return * v;
+    }, std::move( v) );
+    BOOST_CHECK_EQUAL( 7, f.get() );
+}
+
+void test_nested() {
+    std::atomic< int > count{ 0 };
+    boost::fibers::pool p{ 2, boost::fibers::pool::algorithm< boost::fibers::algo::shared_work >() };
+    for ( int i = 0; i < 10; ++i) {
+        p.post( [&p,&count](){
+            // submitted from a worker fiber
+            p.post( [&count](){ ++count; });
+            ++count;
+        });
+    }
+    // wait till the nested tasks are posted
+    while ( 20 != count.load() ) {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1) );
+    }
+    p.shutdown();
+    BOOST_CHECK_EQUAL( 20, count.load() );
+}
+
+void test_shutdown() {
+    boost::fibers::pool p{ 2, boost::fibers::pool::algorithm< boost::fibers::algo::round_robin >() };
+    p.shutdown();
+    // idempotent
+    p.shutdown();
+    bool thrown = false;
+    try {
+        p.post( [](){});
+    } catch ( boost::fibers::fiber_error const&) {
+        thrown = true;
+    }
+    BOOST_CHECK( thrown);
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: pool test suite");
+
+    test->add( BOOST_TEST_CASE( & test_post) );
+    test->add( BOOST_TEST_CASE( & test_submit) );
+    test->add( BOOST_TEST_CASE( & test_move_only) );
+    test->add( BOOST_TEST_CASE( & test_nested) );
+    test->add( BOOST_TEST_CASE( & test_shutdown) );
+
+    return test;
+}
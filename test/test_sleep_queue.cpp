@@ -0,0 +1,129 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+typedef std::chrono::steady_clock   clock_type;
+
+void sleeper( std::chrono::milliseconds d, std::vector< int > & order, int id, bool & ok) {
+    clock_type::time_point tp = clock_type::now() + d;
+    boost::this_fiber::sleep_until( tp);
+    ok = ok && clock_type::now() >= tp;
+    order.push_back( id);
+}
+
+void test_wheel_order() {
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::timer_wheel);
+    BOOST_CHECK( boost::fibers::sleep_queue_policy::timer_wheel ==
+                 boost::fibers::context::active()->get_scheduler()->get_sleep_queue_policy() );
+    std::vector< int > order;
+    bool ok = true;
+    // 80ms crosses the boundary of the first level of the wheel
+    boost::fibers::fiber f1( sleeper, std::chrono::milliseconds( 80), std::ref( order), 3, std::ref( ok) );
+    boost::fibers::fiber f2( sleeper, std::chrono::milliseconds( 5), std::ref( order), 1, std::ref( ok) );
+    boost::fibers::fiber f3( sleeper, std::chrono::milliseconds( 30), std::ref( order), 2, std::ref( ok) );
+    f1.join();
+    f2.join();
+    f3.join();
+    BOOST_CHECK( ok);
+    BOOST_REQUIRE_EQUAL( std::size_t( 3), order.size() );
+    BOOST_CHECK_EQUAL( 1, order[0]);
+    BOOST_CHECK_EQUAL( 2, order[1]);
+    BOOST_CHECK_EQUAL( 3, order[2]);
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::ordered_set);
+}
+
+void test_wheel_many() {
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::timer_wheel);
+    std::minstd_rand generator{ 42 };
+    std::uniform_int_distribution< int > distribution{ 0, 150 };
+    std::vector< int > order;
+    bool ok = true;
+    std::vector< boost::fibers::fiber > fibers;
+    for ( int i = 0; i < 1000; ++i) {
+        fibers.emplace_back( sleeper, std::chrono::milliseconds( distribution( generator) ), std::ref( order), i, std::ref( ok) );
+    }
+    for ( boost::fibers::fiber & f : fibers) {
+        f.join();
+    }
+    BOOST_CHECK( ok);
+    BOOST_CHECK_EQUAL( std::size_t( 1000), order.size() );
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::ordered_set);
+}
+
+void test_wheel_cancel() {
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::timer_wheel);
+    boost::fibers::mutex mtx;
+    boost::fibers::condition_variable cond;
+    bool flag = false;
+    boost::fibers::cv_status status = boost::fibers::cv_status::timeout;
+    clock_type::time_point start = clock_type::now();
+    boost::fibers::fiber waiter( [&](){
+        std::unique_lock< boost::fibers::mutex > lk( mtx);
+        // timed wait is canceled by notification, context is unlinked from the wheel
+        status = cond.wait_for( lk, std::chrono::seconds( 10) );
+    });
+    boost::fibers::fiber notifier( [&](){
+        boost::this_fiber::sleep_for( std::chrono::milliseconds( 10) );
+        std::unique_lock< boost::fibers::mutex > lk( mtx);
+        flag = true;
+        cond.notify_one();
+    });
+    waiter.join();
+    notifier.join();
+    BOOST_CHECK( flag);
+    BOOST_CHECK( boost::fibers::cv_status::no_timeout == status);
+    BOOST_CHECK( clock_type::now() - start < std::chrono::seconds( 5) );
+    // timed wait that times out
+    {
+        std::unique_lock< boost::fibers::mutex > lk( mtx);
+        start = clock_type::now();
+        status = cond.wait_for( lk, std::chrono::milliseconds( 20) );
+        BOOST_CHECK( boost::fibers::cv_status::timeout == status);
+        BOOST_CHECK( clock_type::now() - start >= std::chrono::milliseconds( 20) );
+    }
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::ordered_set);
+}
+
+void test_switch_policy() {
+    std::vector< int > order;
+    bool ok = true;
+    boost::fibers::fiber f1( sleeper, std::chrono::milliseconds( 40), std::ref( order), 2, std::ref( ok) );
+    boost::fibers::fiber f2( sleeper, std::chrono::milliseconds( 20), std::ref( order), 1, std::ref( ok) );
+    // let both fibers enter the sleep-queue
+    boost::this_fiber::yield();
+    // migrate sleeping fibers into the timing wheel and back
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::timer_wheel);
+    boost::this_fiber::sleep_for( std::chrono::milliseconds( 5) );
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::ordered_set);
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::timer_wheel);
+    f1.join();
+    f2.join();
+    BOOST_CHECK( ok);
+    BOOST_REQUIRE_EQUAL( std::size_t( 2), order.size() );
+    BOOST_CHECK_EQUAL( 1, order[0]);
+    BOOST_CHECK_EQUAL( 2, order[1]);
+    boost::fibers::use_sleep_queue( boost::fibers::sleep_queue_policy::ordered_set);
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: sleep-queue test suite");
+
+    test->add( BOOST_TEST_CASE( & test_wheel_order) );
+    test->add( BOOST_TEST_CASE( & test_wheel_many) );
+    test->add( BOOST_TEST_CASE( & test_wheel_cancel) );
+    test->add( BOOST_TEST_CASE( & test_switch_policy) );
+
+    return test;
+}
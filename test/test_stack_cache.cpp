@@ -0,0 +1,134 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+void record( std::uintptr_t & addr) {
+    char c = 0;
+    addr = reinterpret_cast< std::uintptr_t >( & c);
+}
+
+std::size_t cached() {
+    return boost::fibers::context::active()->get_scheduler()->get_stack_cache()->size();
+}
+
+void release() {
+    // terminated fibers are released by the dispatcher
+    boost::this_fiber::yield();
+}
+
+void enable() {
+    boost::fibers::set_stack_cache_limits( 64, 32 * 1024 * 1024);
+}
+
+void test_disabled_by_default() {
+    boost::fibers::fixedsize_stack salloc{ 64 * 1024 };
+    std::uintptr_t addr = 0;
+    boost::fibers::fiber( std::allocator_arg, salloc, record, std::ref( addr) ).join();
+    release();
+    BOOST_CHECK_EQUAL( std::size_t( 0), cached() );
+}
+
+void test_reuse() {
+    enable();
+    boost::fibers::trim_stack_cache();
+    boost::fibers::fixedsize_stack salloc{ 64 * 1024 };
+    std::uintptr_t addr1 = 0;
+    std::uintptr_t addr2 = 0;
+    boost::fibers::fiber( std::allocator_arg, salloc, record, std::ref( addr1) ).join();
+    release();
+    BOOST_CHECK_EQUAL( std::size_t( 1), cached() );
+    boost::fibers::fiber( std::allocator_arg, salloc, record, std::ref( addr2) ).join();
+    release();
+    BOOST_CHECK( 0 != addr1);
+    // same stack, same frame
+    BOOST_CHECK_EQUAL( addr1, addr2);
+    BOOST_CHECK_EQUAL( std::size_t( 1), cached() );
+    boost::fibers::trim_stack_cache();
+    BOOST_CHECK_EQUAL( std::size_t( 0), cached() );
+}
+
+void test_keyed_by_size() {
+    enable();
+    boost::fibers::trim_stack_cache();
+    boost::fibers::fixedsize_stack small{ 64 * 1024 };
+    boost::fibers::fixedsize_stack large{ 128 * 1024 };
+    boost::fibers::protected_fixedsize_stack prot{ 64 * 1024 };
+    std::uintptr_t addr1 = 0;
+    std::uintptr_t addr2 = 0;
+    std::uintptr_t addr3 = 0;
+    boost::fibers::fiber( std::allocator_arg, small, record, std::ref( addr1) ).join();
+    release();
+    // different size, different allocator type: no reuse
+    boost::fibers::fiber( std::allocator_arg, large, record, std::ref( addr2) ).join();
+    boost::fibers::fiber( std::allocator_arg, prot, record, std::ref( addr3) ).join();
+    release();
+    BOOST_CHECK( addr1 != addr2);
+    BOOST_CHECK( addr1 != addr3);
+    BOOST_CHECK_EQUAL( std::size_t( 3), cached() );
+    boost::fibers::trim_stack_cache();
+}
+
+void test_limits() {
+    boost::fibers::trim_stack_cache();
+    boost::fibers::set_stack_cache_limits( 2, 1024 * 1024);
+    boost::fibers::fixedsize_stack salloc{ 64 * 1024 };
+    std::vector< boost::fibers::fiber > fibers;
+    std::vector< std::uintptr_t > addrs( 8, 0);
+    for ( std::size_t i = 0; i < addrs.size(); ++i) {
+        fibers.emplace_back( std::allocator_arg, salloc, record, std::ref( addrs[i]) );
+    }
+    for ( boost::fibers::fiber & f : fibers) {
+        f.join();
+    }
+    fibers.clear();
+    release();
+    BOOST_CHECK_EQUAL( std::size_t( 2), cached() );
+    // no caching
+    boost::fibers::set_stack_cache_limits( 0, 0);
+    BOOST_CHECK_EQUAL( std::size_t( 0), cached() );
+    boost::fibers::fiber( std::allocator_arg, salloc, record, std::ref( addrs[0]) ).join();
+    release();
+    BOOST_CHECK_EQUAL( std::size_t( 0), cached() );
+    boost::fibers::set_stack_cache_limits( BOOST_FIBERS_STACK_CACHE_MAX_COUNT, BOOST_FIBERS_STACK_CACHE_MAX_BYTES);
+}
+
+void test_pooled() {
+    enable();
+    boost::fibers::trim_stack_cache();
+    boost::fibers::pooled_fixedsize_stack pool1{ 64 * 1024 };
+    boost::fibers::pooled_fixedsize_stack pool2{ 64 * 1024 };
+    std::uintptr_t addr1 = 0;
+    std::uintptr_t addr2 = 0;
+    boost::fibers::fiber( std::allocator_arg, pool1, record, std::ref( addr1) ).join();
+    release();
+    // stack of pool1 is not handed out for pool2
+    boost::fibers::fiber( std::allocator_arg, pool2, record, std::ref( addr2) ).join();
+    release();
+    BOOST_CHECK( addr1 != addr2);
+    BOOST_CHECK_EQUAL( std::size_t( 2), cached() );
+    // stacks are returned to their pools
+    boost::fibers::trim_stack_cache();
+    BOOST_CHECK_EQUAL( std::size_t( 0), cached() );
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: stack-cache test suite");
+
+    test->add( BOOST_TEST_CASE( & test_disabled_by_default) );
+    test->add( BOOST_TEST_CASE( & test_reuse) );
+    test->add( BOOST_TEST_CASE( & test_keyed_by_size) );
+    test->add( BOOST_TEST_CASE( & test_limits) );
+    test->add( BOOST_TEST_CASE( & test_pooled) );
+
+    return test;
+}
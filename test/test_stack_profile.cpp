@@ -0,0 +1,95 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+void use_stack( std::size_t size) {
+    volatile char buffer[8 * 1024];
+    // the stack grows downwards
+    for ( std::size_t i = 0; i < size && i < sizeof( buffer); ++i) {
+        buffer[sizeof( buffer) - 1 - i] = 1;
+    }
+}
+
+void release() {
+    // terminated fibers are released by the dispatcher
+    boost::this_fiber::yield();
+}
+
+void test_disabled() {
+    boost::fibers::enable_stack_profiling( false);
+    boost::fibers::reset_stack_usage();
+    boost::fibers::fixedsize_stack salloc{ 64 * 1024 };
+    boost::fibers::fiber( std::allocator_arg, salloc, use_stack, 1024).join();
+    release();
+    BOOST_CHECK( boost::fibers::get_stack_usage().empty() );
+}
+
+void test_high_water_mark() {
+    boost::fibers::enable_stack_profiling();
+    boost::fibers::reset_stack_usage();
+    boost::fibers::fixedsize_stack salloc{ 64 * 1024 };
+    boost::fibers::fiber( std::allocator_arg, salloc, use_stack, 1024).join();
+    boost::fibers::fiber( std::allocator_arg, salloc, use_stack, 8 * 1024).join();
+    release();
+    boost::fibers::enable_stack_profiling( false);
+    std::vector< boost::fibers::stack_usage > usage = boost::fibers::get_stack_usage();
+    BOOST_REQUIRE_EQUAL( std::size_t( 1), usage.size() );
+    BOOST_CHECK_EQUAL( std::uint64_t( 2), usage[0].fibers);
+    BOOST_CHECK_EQUAL( std::size_t( 64 * 1024), usage[0].stack_size);
+    BOOST_CHECK( 8 * 1024 <= usage[0].max_used);
+    BOOST_CHECK( 64 * 1024 > usage[0].max_used);
+    BOOST_CHECK( usage[0].mean_used < usage[0].max_used);
+#if ! defined(BOOST_NO_RTTI)
+    // demangled type name
+    BOOST_CHECK( std::string::npos != usage[0].allocator.find("boost::context::") );
+#endif
+}
+
+void test_guard_page() {
+    boost::fibers::enable_stack_profiling();
+    boost::fibers::reset_stack_usage();
+    boost::fibers::protected_fixedsize_stack salloc{ 64 * 1024 };
+    boost::fibers::fiber( std::allocator_arg, salloc, use_stack, 1024).join();
+    release();
+    boost::fibers::enable_stack_profiling( false);
+    std::vector< boost::fibers::stack_usage > usage = boost::fibers::get_stack_usage();
+    BOOST_REQUIRE_EQUAL( std::size_t( 1), usage.size() );
+    // the guard page is neither filled nor counted
+    BOOST_CHECK_EQUAL( std::size_t( 64 * 1024), usage[0].stack_size);
+    BOOST_CHECK( 1024 <= usage[0].max_used);
+}
+
+void test_write() {
+    boost::fibers::enable_stack_profiling();
+    boost::fibers::reset_stack_usage();
+    boost::fibers::fixedsize_stack salloc{ 64 * 1024 };
+    boost::fibers::fiber( std::allocator_arg, salloc, use_stack, 1024).join();
+    release();
+    boost::fibers::enable_stack_profiling( false);
+    std::ostringstream os;
+    boost::fibers::write_stack_usage( os);
+    BOOST_CHECK( std::string::npos != os.str().find("65536") );
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: stack profile test suite");
+
+    test->add( BOOST_TEST_CASE( & test_disabled) );
+    test->add( BOOST_TEST_CASE( & test_high_water_mark) );
+    test->add( BOOST_TEST_CASE( & test_guard_page) );
+    test->add( BOOST_TEST_CASE( & test_write) );
+
+    return test;
+}
@@ -0,0 +1,176 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+typedef boost::fibers::unbuffered_channel< int >   channel_type;
+
+void test_spawn_terminate() {
+    boost::fibers::scheduler_statistics before = boost::fibers::get_statistics();
+    std::vector< boost::fibers::fiber > fibers;
+    for ( int i = 0; i < 10; ++i) {
+        fibers.emplace_back( [](){
+            boost::this_fiber::yield();
+        });
+    }
+    for ( boost::fibers::fiber & f : fibers) {
+        f.join();
+    }
+    boost::fibers::scheduler_statistics after = boost::fibers::get_statistics();
+    BOOST_CHECK_EQUAL( before.fibers_spawned + 10, after.fibers_spawned);
+    BOOST_CHECK_EQUAL( before.fibers_terminated + 10, after.fibers_terminated);
+    // each fiber is resumed at least twice
+    BOOST_CHECK( before.context_switches + 20 <= after.context_switches);
+    // joining fibers are woken up by the terminating fibers
+    BOOST_CHECK( before.local_wakeups < after.local_wakeups);
+    BOOST_CHECK( 10 <= after.ready_queue_high_water_mark);
+}
+
+void test_park() {
+    boost::fibers::scheduler_statistics before = boost::fibers::get_statistics();
+    boost::this_fiber::sleep_for( std::chrono::milliseconds( 20) );
+    boost::fibers::scheduler_statistics after = boost::fibers::get_statistics();
+    BOOST_CHECK( before.parks < after.parks);
+    BOOST_CHECK( before.park_time + std::chrono::milliseconds( 10) <= after.park_time);
+}
+
+void test_remote_wakeup() {
+    boost::fibers::scheduler_statistics before = boost::fibers::get_statistics();
+    channel_type chan;
+    std::thread t( [&chan](){
+        for ( int i = 0; i < 10; ++i) {
+            chan.push( i);
+        }
+    });
+    int sum = 0;
+    for ( int i = 0; i < 10; ++i) {
+        sum += chan.value_pop();
+    }
+    t.join();
+    boost::fibers::scheduler_statistics after = boost::fibers::get_statistics();
+    BOOST_CHECK_EQUAL( 45, sum);
+    BOOST_CHECK( before.remote_wakeups < after.remote_wakeups);
+    BOOST_CHECK( after.remote_wakeups - before.remote_wakeups <= 10);
+    BOOST_CHECK( after.unparks - before.unparks <= after.remote_wakeups - before.remote_wakeups);
+}
+
+void test_snapshot_from_other_thread() {
+    boost::fibers::scheduler * sched = boost::fibers::context::active()->get_scheduler();
+    boost::fibers::fiber( [](){ boost::this_fiber::yield(); }).join();
+    boost::fibers::scheduler_statistics stats;
+    std::thread t( [sched,&stats](){
+        stats = sched->get_statistics();
+    });
+    t.join();
+    BOOST_CHECK( 0 < stats.fibers_spawned);
+    BOOST_CHECK( 0 < stats.context_switches);
+}
+
+void test_snapshot_while_set_algo() {
+    std::atomic< boost::fibers::scheduler * > sched{ nullptr };
+    std::atomic< bool > done{ false };
+    std::size_t hwm = 0;
+    std::thread t( [&sched,&done,&hwm](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::round_robin >();
+        std::vector< boost::fibers::fiber > fibers;
+        for ( int i = 0; i < 4; ++i) {
+            fibers.emplace_back( [](){ boost::this_fiber::yield(); });
+        }
+        for ( boost::fibers::fiber & f : fibers) {
+            f.join();
+        }
+        sched = boost::fibers::context::active()->get_scheduler();
+        // the sched-algorithm is replaced while other threads take snapshots
+        for ( int i = 0; i < 1000; ++i) {
+            boost::fibers::use_scheduling_algorithm< boost::fibers::algo::round_robin >();
+        }
+        // the counters survive the replacement
+        hwm = boost::fibers::get_statistics().ready_queue_high_water_mark;
+        while ( ! done) {
+            std::this_thread::yield();
+        }
+    });
+    while ( nullptr == sched.load() ) {
+        std::this_thread::yield();
+    }
+    for ( int i = 0; i < 1000; ++i) {
+        BOOST_CHECK( 4 <= sched.load()->get_statistics().ready_queue_high_water_mark);
+    }
+    done = true;
+    t.join();
+    BOOST_CHECK( 4 <= hwm);
+}
+
+void test_shared_work_high_water_mark() {
+    // the high-water mark is recorded per scheduler
+    std::size_t hwm1 = 0;
+    std::size_t hwm2 = 0;
+    std::thread t1( [&hwm1](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::shared_work >();
+        std::vector< boost::fibers::fiber > fibers;
+        for ( int i = 0; i < 8; ++i) {
+            fibers.emplace_back( [](){ boost::this_fiber::yield(); });
+        }
+        for ( boost::fibers::fiber & f : fibers) {
+            f.join();
+        }
+        hwm1 = boost::fibers::get_statistics().ready_queue_high_water_mark;
+    });
+    t1.join();
+    std::thread t2( [&hwm2](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::shared_work >();
+        hwm2 = boost::fibers::get_statistics().ready_queue_high_water_mark;
+    });
+    t2.join();
+    BOOST_CHECK( 0 < hwm1);
+    // only the dispatcher context queued by the default algorithm
+    BOOST_CHECK( hwm2 <= 1);
+}
+
+void test_work_stealing_high_water_mark() {
+    for ( boost::fibers::ready_queue_policy policy : { boost::fibers::ready_queue_policy::spinlock,
+                                                       boost::fibers::ready_queue_policy::spmc,
+                                                       boost::fibers::ready_queue_policy::bounded }) {
+        std::size_t hwm = 0;
+        std::thread t( [policy,&hwm](){
+            boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >(
+                std::make_shared< boost::fibers::algo::stealing_domain >( 1, policy) );
+            std::vector< boost::fibers::fiber > fibers;
+            for ( int i = 0; i < 10; ++i) {
+                fibers.emplace_back( [](){ boost::this_fiber::yield(); });
+            }
+            for ( boost::fibers::fiber & f : fibers) {
+                f.join();
+            }
+            hwm = boost::fibers::get_statistics().ready_queue_high_water_mark;
+        });
+        t.join();
+        BOOST_CHECK( 10 <= hwm);
+    }
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: statistics test suite");
+
+    test->add( BOOST_TEST_CASE( & test_spawn_terminate) );
+    test->add( BOOST_TEST_CASE( & test_park) );
+    test->add( BOOST_TEST_CASE( & test_remote_wakeup) );
+    test->add( BOOST_TEST_CASE( & test_snapshot_from_other_thread) );
+    test->add( BOOST_TEST_CASE( & test_snapshot_while_set_algo) );
+    test->add( BOOST_TEST_CASE( & test_shared_work_high_water_mark) );
+    test->add( BOOST_TEST_CASE( & test_work_stealing_high_water_mark) );
+
+    return test;
+}
@@ -0,0 +1,131 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+typedef boost::fibers::algo::stealing_domain    domain_type;
+
+void test_batch( boost::fibers::ready_queue_policy policy) {
+    const int n = 64;
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 2, policy);
+    std::atomic< int > done{ 0 };
+    std::atomic< bool > spawned{ false };
+    std::atomic< bool > stop{ false };
+    std::thread::id victim_id{};
+    std::atomic< int > on_victim{ 0 };
+    boost::fibers::scheduler_statistics thief_stats{};
+    std::thread victim( [d,n,&done,&spawned,&victim_id,&on_victim](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( d);
+        victim_id = std::this_thread::get_id();
+        std::vector< boost::fibers::fiber > fibers;
+        for ( int i = 0; i < n; ++i) {
+            fibers.emplace_back( [&done,&victim_id,&on_victim](){
+                if ( victim_id == std::this_thread::get_id() ) {
+                    ++on_victim;
+                }
+                ++done;
+            });
+        }
+        spawned = true;
+        // the thread is blocked, all fibers are stolen
+        while ( n != done) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1) );
+        }
+        for ( boost::fibers::fiber & f : fibers) {
+            f.join();
+        }
+    });
+    while ( ! spawned) {
+        std::this_thread::yield();
+    }
+    std::thread thief( [d,&stop,&thief_stats](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( d);
+        while ( ! stop) {
+            boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+        }
+        thief_stats = boost::fibers::get_statistics();
+    });
+    victim.join();
+    stop = true;
+    thief.join();
+    BOOST_CHECK_EQUAL( n, done.load() );
+    BOOST_CHECK_EQUAL( 0, on_victim.load() );
+    // up to half of the victim's queue is moved by one steal:
+    // 32 + 16 + 8 + 4 + 2 + 1 + 1
+    BOOST_CHECK( 0 < thief_stats.steal_successes);
+    BOOST_CHECK( 7 >= thief_stats.steal_successes);
+}
+
+void test_batch_spinlock() {
+    test_batch( boost::fibers::ready_queue_policy::spinlock);
+}
+
+void test_batch_spmc() {
+    test_batch( boost::fibers::ready_queue_policy::spmc);
+}
+
+void test_batch_bounded() {
+    test_batch( boost::fibers::ready_queue_policy::bounded);
+}
+
+void test_grow_while_stealing() {
+    // more fibers than the initial capacity of the deque, the victim's
+    // deque grows (retiring arrays) while the thieves steal from it
+    const int n = 10000;
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >(
+            3, boost::fibers::ready_queue_policy::spmc);
+    std::atomic< int > done{ 0 };
+    std::atomic< bool > stop{ false };
+    std::vector< std::thread > thieves;
+    for ( int i = 0; i < 2; ++i) {
+        thieves.emplace_back( [d,&stop](){
+            boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( d);
+            while ( ! stop) {
+                boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+            }
+        });
+    }
+    std::thread victim( [d,n,&done](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( d);
+        std::vector< boost::fibers::fiber > fibers;
+        fibers.reserve( n);
+        for ( int i = 0; i < n; ++i) {
+            fibers.emplace_back( std::allocator_arg, boost::fibers::fixedsize_stack{ 16 * 1024 },
+                                 [&done](){
+                                     boost::this_fiber::yield();
+                                     ++done;
+                                 });
+        }
+        for ( boost::fibers::fiber & f : fibers) {
+            f.join();
+        }
+    });
+    victim.join();
+    stop = true;
+    for ( std::thread & t : thieves) {
+        t.join();
+    }
+    BOOST_CHECK_EQUAL( n, done.load() );
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: steal-half test suite");
+
+    test->add( BOOST_TEST_CASE( & test_batch_spinlock) );
+    test->add( BOOST_TEST_CASE( & test_batch_spmc) );
+    test->add( BOOST_TEST_CASE( & test_batch_bounded) );
+    test->add( BOOST_TEST_CASE( & test_grow_while_stealing) );
+
+    return test;
+}
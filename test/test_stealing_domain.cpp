@@ -0,0 +1,165 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+typedef boost::fibers::algo::stealing_domain    domain_type;
+
+struct recorder {
+    std::mutex                  mtx{};
+    std::set< std::thread::id > workers{};
+    std::set< std::thread::id > seen{};
+
+    void worker() {
+        std::unique_lock< std::mutex > lk{ mtx };
+        workers.insert( std::this_thread::get_id() );
+    }
+
+    void run() {
+        for ( int i = 0; i < 20; ++i) {
+            {
+                std::unique_lock< std::mutex > lk{ mtx };
+                seen.insert( std::this_thread::get_id() );
+            }
+            boost::this_fiber::yield();
+        }
+    }
+};
+
+boost::fibers::pool::initializer_type init( std::shared_ptr< domain_type > domain, recorder & r) {
+    return [domain,&r]( std::uint32_t) {
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( domain);
+        r.worker();
+    };
+}
+
+void test_isolation() {
+    recorder ra, rb;
+    std::shared_ptr< domain_type > da = std::make_shared< domain_type >( 2);
+    std::shared_ptr< domain_type > db = std::make_shared< domain_type >( 2);
+    {
+        boost::fibers::pool a{ 2, init( da, ra) };
+        boost::fibers::pool b{ 2, init( db, rb) };
+        for ( int i = 0; i < 20; ++i) {
+            a.post( [&ra](){ ra.run(); });
+            b.post( [&rb](){ rb.run(); });
+        }
+    }
+    BOOST_CHECK_EQUAL( std::size_t( 2), ra.workers.size() );
+    BOOST_CHECK_EQUAL( std::size_t( 2), rb.workers.size() );
+    // fibers of a domain run only in threads of this domain
+    for ( std::thread::id id : ra.seen) {
+        BOOST_CHECK( 0 != ra.workers.count( id) );
+    }
+    for ( std::thread::id id : rb.seen) {
+        BOOST_CHECK( 0 != rb.workers.count( id) );
+    }
+}
+
+void test_slots() {
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 1);
+    BOOST_CHECK_EQUAL( std::uint32_t( 1), d->size() );
+    std::thread t( [d](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( d);
+        // all slots are in use
+        bool thrown = false;
+        try {
+            boost::fibers::algo::work_stealing ws{ d };
+        } catch ( boost::fibers::fiber_error const&) {
+            thrown = true;
+        }
+        BOOST_CHECK( thrown);
+        // a single scheduler does not try to steal
+        boost::fibers::fiber( [](){ boost::this_fiber::yield(); }).join();
+    });
+    t.join();
+}
+
+void test_shrink() {
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 1);
+    const std::size_t initial = d->queue( 0).capacity();
+    std::thread t( [d,initial](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( d);
+        boost::fibers::fixedsize_stack salloc{ 16 * 1024 };
+        int count = 0;
+        // spike of ready fibers
+        for ( std::size_t i = 0; i < initial + initial / 2; ++i) {
+            boost::fibers::fiber{ std::allocator_arg, salloc, [&count](){ ++count; } }.detach();
+        }
+        BOOST_CHECK( initial < d->queue( 0).capacity() );
+        // all fibers run, afterwards the scheduler becomes idle
+        while ( static_cast< std::size_t >( count) != initial + initial / 2) {
+            boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+        }
+        boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+        BOOST_CHECK_EQUAL( initial, d->queue( 0).capacity() );
+    });
+    t.join();
+}
+
+void test_policies() {
+    const boost::fibers::ready_queue_policy policies[] = {
+        boost::fibers::ready_queue_policy::spinlock,
+        boost::fibers::ready_queue_policy::spmc,
+        boost::fibers::ready_queue_policy::bounded };
+    for ( boost::fibers::ready_queue_policy policy : policies) {
+        recorder r;
+        std::shared_ptr< domain_type > d = std::make_shared< domain_type >( 2, policy);
+        BOOST_CHECK( policy == d->policy() );
+        BOOST_CHECK( policy == d->queue( 1).policy() );
+        std::atomic< int > count{ 0 };
+        {
+            boost::fibers::pool p{ 2, init( d, r) };
+            for ( int i = 0; i < 20; ++i) {
+                p.post( [&r,&count](){ r.run(); ++count; });
+            }
+        }
+        BOOST_CHECK_EQUAL( 20, count.load() );
+    }
+}
+
+void test_bounded_spill() {
+    std::shared_ptr< domain_type > d = std::make_shared< domain_type >(
+            1, boost::fibers::ready_queue_policy::bounded);
+    const std::size_t capacity = d->queue( 0).capacity();
+    std::thread t( [d,capacity](){
+        boost::fibers::use_scheduling_algorithm< boost::fibers::algo::work_stealing >( d);
+        boost::fibers::fixedsize_stack salloc{ 16 * 1024 };
+        std::size_t count = 0;
+        for ( std::size_t i = 0; i < 2 * capacity; ++i) {
+            boost::fibers::fiber{ std::allocator_arg, salloc, [&count](){ ++count; } }.detach();
+        }
+        // the ring does not grow, contexts have been spilled
+        BOOST_CHECK_EQUAL( capacity, d->queue( 0).capacity() );
+        BOOST_CHECK( ! d->overflow().empty() );
+        while ( count != 2 * capacity) {
+            boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+        }
+    });
+    t.join();
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: stealing-domain test suite");
+
+    test->add( BOOST_TEST_CASE( & test_isolation) );
+    test->add( BOOST_TEST_CASE( & test_slots) );
+    test->add( BOOST_TEST_CASE( & test_shrink) );
+    test->add( BOOST_TEST_CASE( & test_policies) );
+    test->add( BOOST_TEST_CASE( & test_bounded_spill) );
+
+    return test;
+}
@@ -0,0 +1,118 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <ios>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+std::string drain() {
+    std::ostringstream os;
+    boost::fibers::write_chrome_trace( os);
+    return os.str();
+}
+
+bool contains( std::string const& s, std::string const& what) {
+    return std::string::npos != s.find( what);
+}
+
+void test_disabled() {
+    drain();
+    boost::fibers::enable_tracing( false);
+    boost::fibers::fiber( [](){
+        boost::this_fiber::yield();
+    }).join();
+    std::string trace = drain();
+    BOOST_CHECK( ! contains( trace, "\"spawn\"") );
+    BOOST_CHECK( ! contains( trace, "\"ph\":\"X\"") );
+}
+
+void test_events() {
+    drain();
+    boost::fibers::enable_tracing();
+    std::vector< boost::fibers::fiber > fibers;
+    for ( int i = 0; i < 4; ++i) {
+        fibers.emplace_back( [](){
+            boost::this_fiber::yield();
+            boost::this_fiber::sleep_for( std::chrono::milliseconds( 1) );
+        });
+    }
+    for ( boost::fibers::fiber & f : fibers) {
+        f.join();
+    }
+    // closes the slice of the main-context
+    boost::this_fiber::yield();
+    boost::fibers::enable_tracing( false);
+    std::string trace = drain();
+    BOOST_CHECK( 0 == trace.find( "{\"traceEvents\":[") );
+    BOOST_CHECK( contains( trace, "\"spawn\"") );
+    BOOST_CHECK( contains( trace, "\"block\"") );
+    BOOST_CHECK( contains( trace, "\"wake\"") );
+    BOOST_CHECK( contains( trace, "\"terminate\"") );
+    BOOST_CHECK( contains( trace, "\"park\"") );
+    // running contexts are written as slices
+    BOOST_CHECK( contains( trace, "\"name\":\"main\",\"cat\":\"fiber\",\"ph\":\"X\"") );
+    BOOST_CHECK( contains( trace, "\"name\":\"dispatcher\",\"cat\":\"fiber\",\"ph\":\"X\"") );
+    BOOST_CHECK( contains( trace, "\"name\":\"fiber 0x") );
+    // buffers have been drained
+    BOOST_CHECK( ! contains( drain(), "\"spawn\"") );
+}
+
+void test_remote_wake() {
+    drain();
+    boost::fibers::enable_tracing();
+    boost::fibers::unbuffered_channel< int > chan;
+    std::thread t( [&chan](){
+        // the main-context is blocked in value_pop() before
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10) );
+        chan.push( 1);
+    });
+    BOOST_CHECK_EQUAL( 1, chan.value_pop() );
+    t.join();
+    boost::fibers::enable_tracing( false);
+    std::string trace = drain();
+    BOOST_CHECK( contains( trace, "\"remote_wake\"") );
+}
+
+void test_format() {
+    drain();
+    boost::fibers::enable_tracing();
+    boost::fibers::fiber( [](){
+        boost::this_fiber::yield();
+    }).join();
+    boost::fibers::enable_tracing( false);
+    std::ostringstream os;
+    os.precision( 2);
+    boost::fibers::write_chrome_trace( os);
+    std::string trace = os.str();
+    // timestamps are written in fixed notation with nanosecond resolution
+    BOOST_CHECK( ! contains( trace, "e+") );
+    std::string::size_type pos = trace.find( "\"ts\":");
+    BOOST_REQUIRE( std::string::npos != pos);
+    pos = trace.find_first_of( ".,}", pos + 5);
+    BOOST_REQUIRE( std::string::npos != pos);
+    BOOST_CHECK_EQUAL( '.', trace[pos]);
+    // the format of the stream is restored
+    BOOST_CHECK( 0 == ( os.flags() & std::ios_base::fixed) );
+    BOOST_CHECK_EQUAL( 2, os.precision() );
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: trace test suite");
+
+    test->add( BOOST_TEST_CASE( & test_disabled) );
+    test->add( BOOST_TEST_CASE( & test_events) );
+    test->add( BOOST_TEST_CASE( & test_remote_wake) );
+    test->add( BOOST_TEST_CASE( & test_format) );
+
+    return test;
+}
@@ -0,0 +1,97 @@
+//          Copyright Oliver Kowalke 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/fiber/all.hpp>
+
+struct reports {
+    std::mutex                                  mtx{};
+    std::vector< boost::fibers::context::id >   ids{};
+    std::thread::id                             thread{};
+
+    void operator()( boost::fibers::context::id id, std::thread::id thread_,
+                     std::chrono::steady_clock::duration elapsed) {
+        BOOST_CHECK( std::chrono::milliseconds( 20) <= elapsed);
+        std::unique_lock< std::mutex > lk{ mtx };
+        ids.push_back( id);
+        thread = thread_;
+    }
+
+    std::size_t size() {
+        std::unique_lock< std::mutex > lk{ mtx };
+        return ids.size();
+    }
+};
+
+void busy( std::chrono::milliseconds ms) {
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + ms;
+    while ( std::chrono::steady_clock::now() < end) {
+    }
+}
+
+void test_stall() {
+    reports r;
+    boost::fibers::watchdog wd{ std::chrono::milliseconds( 20), std::ref( r) };
+    wd.watch();
+    boost::fibers::context::id id;
+    boost::fibers::fiber f( [&id](){
+        id = boost::this_fiber::get_id();
+        // does not yield
+        busy( std::chrono::milliseconds( 200) );
+    });
+    f.join();
+    wd.unwatch();
+    BOOST_REQUIRE_EQUAL( std::size_t( 1), r.size() );
+    BOOST_CHECK( id == r.ids[0]);
+    BOOST_CHECK( std::this_thread::get_id() == r.thread);
+}
+
+void test_yielding() {
+    reports r;
+    boost::fibers::watchdog wd{ std::chrono::milliseconds( 100), std::ref( r) };
+    wd.watch();
+    boost::fibers::fiber f( [](){
+        for ( int i = 0; i < 20; ++i) {
+            busy( std::chrono::milliseconds( 5) );
+            boost::this_fiber::yield();
+        }
+    });
+    f.join();
+    wd.unwatch();
+    BOOST_CHECK_EQUAL( std::size_t( 0), r.size() );
+}
+
+void test_other_thread() {
+    reports r;
+    boost::fibers::watchdog wd{ std::chrono::milliseconds( 20), std::ref( r) };
+    std::thread t( [&wd](){
+        wd.watch();
+        boost::fibers::fiber( [](){
+            busy( std::chrono::milliseconds( 200) );
+        }).join();
+        // scheduler of this thread detaches itself
+    });
+    std::thread::id tid = t.get_id();
+    t.join();
+    BOOST_REQUIRE_EQUAL( std::size_t( 1), r.size() );
+    BOOST_CHECK( tid == r.thread);
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* []) {
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Fiber: watchdog test suite");
+
+    test->add( BOOST_TEST_CASE( & test_stall) );
+    test->add( BOOST_TEST_CASE( & test_yielding) );
+    test->add( BOOST_TEST_CASE( & test_other_thread) );
+
+    return test;
+}